@@ -1,14 +1,149 @@
-#pragma once
-
-
-
-#include <vector>
-
-class BipartiteMWIS {
-
-
-
-	void getMWIS(std::vector<int> V1, std::vector<int> V2) {
-
-	}
-};
\ No newline at end of file
+#pragma once
+
+
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+#include "maxflow.h"
+#include "treepairinfo.h"
+
+
+/**
+  Maximum weight independent set in a bipartite graph, through the classical reduction to a minimum s-t cut:
+  the source is linked to V1 with the weights as capacities, V2 is linked to the sink the same way, and each
+  edge of the graph becomes an infinite capacity arc from V1 to V2.  The V1 vertices on the source side of the cut
+  and the V2 vertices on the sink side form the MWIS.
+  **/
+class BipartiteMWIS {
+public:
+
+
+
+	/**
+	  Gives flow network ids to the vertices having an edge, and -1 to the others.  The source is 0 and the sink is 1.
+	  Returns the number of vertices of the network.
+	  **/
+	static int map_vertices(const IncompatGraph& g, std::vector<int>& fid1, std::vector<int>& fid2) {
+		fid1.assign(g.n1, -1);
+		fid2.assign(g.n2, -1);
+		int nbv = 2;
+		for (uint64_t i = 0; i < g.n1; ++i) {
+			if (g.get_degree(i) > 0)
+				fid1[i] = nbv++;
+			for (uint64_t k = g.offsets[i]; k < g.offsets[i + 1]; ++k) {
+				uint32_t j = g.neighbours[k];
+				if (fid2[j] == -1)
+					fid2[j] = nbv++;
+			}
+		}
+		return nbv;
+	}
+
+
+
+	/**
+	  Adds the arcs of the min-cut network to flow, which can be any max-flow engine with an addEdge(from, to, cap) method.
+	  **/
+	template <class FLOW>
+	static void add_network_edges(FLOW& flow, const std::vector<long long>& w1, const std::vector<long long>& w2, const IncompatGraph& g,
+		const std::vector<int>& fid1, const std::vector<int>& fid2) {
+
+		long long inf = 1;
+		for (uint64_t i = 0; i < g.n1; ++i)
+			if (fid1[i] != -1)
+				inf += w1[i];
+		for (uint64_t j = 0; j < g.n2; ++j)
+			if (fid2[j] != -1)
+				inf += w2[j];
+
+		for (uint64_t i = 0; i < g.n1; ++i) {
+			if (fid1[i] == -1)
+				continue;
+			flow.addEdge(0, fid1[i], w1[i]);
+			for (uint64_t k = g.offsets[i]; k < g.offsets[i + 1]; ++k)
+				flow.addEdge(fid1[i], fid2[g.neighbours[k]], inf);
+		}
+		for (uint64_t j = 0; j < g.n2; ++j) {
+			if (fid2[j] != -1)
+				flow.addEdge(fid2[j], 1, w2[j]);
+		}
+	}
+
+
+
+	/**
+	  w1 and w2 are the weights of V1 and V2, the edges are given by g (V1 = t1 nodes, V2 = t2 nodes).
+	  Fills in1 and in2 with the membership of each vertex in the independent set, and returns its weight.
+	  Vertices without incident edge are always taken, and do not enter the flow network.
+	  **/
+	static long long getMWIS(const std::vector<long long>& w1, const std::vector<long long>& w2, const IncompatGraph& g,
+		std::vector<bool>& in1, std::vector<bool>& in2) {
+
+		in1.assign(g.n1, true);
+		in2.assign(g.n2, true);
+
+		std::vector<int> fid1, fid2;
+		int nbv = map_vertices(g, fid1, fid2);
+
+		PushRelabel pr(nbv);
+		add_network_edges(pr, w1, w2, g, fid1, fid2);
+
+		long long cut = pr.max_flow(0, 1);
+
+		std::vector<bool> source_side(nbv, false);
+		for (int v : pr.getReachableBySource())
+			source_side[v] = true;
+
+		long long total = 0;
+		for (uint64_t i = 0; i < g.n1; ++i) {
+			if (fid1[i] != -1)
+				in1[i] = source_side[fid1[i]];
+			total += w1[i];
+		}
+		for (uint64_t j = 0; j < g.n2; ++j) {
+			if (fid2[j] != -1)
+				in2[j] = !source_side[fid2[j]];
+			total += w2[j];
+		}
+
+		return total - cut;
+	}
+
+
+
+	/**
+	  Same as above, but with real weights (e.g. branch lengths or supports).  Weights are scaled so that the largest
+	  becomes 2^30 and rounded, which keeps all capacity sums far from overflowing.  Negative weights count as 0.
+	  Returns the weight of the independent set in the original scale.
+	  **/
+	static double getMWIS(const std::vector<double>& w1, const std::vector<double>& w2, const IncompatGraph& g,
+		std::vector<bool>& in1, std::vector<bool>& in2) {
+
+		double maxw = 0.0;
+		for (double w : w1)
+			maxw = std::max(maxw, w);
+		for (double w : w2)
+			maxw = std::max(maxw, w);
+
+		double scale = (maxw > 0.0 ? (double)(1 << 30) / maxw : 1.0);
+
+		std::vector<long long> iw1(w1.size()), iw2(w2.size());
+		for (size_t i = 0; i < w1.size(); ++i)
+			iw1[i] = std::llround(std::max(0.0, w1[i]) * scale);
+		for (size_t i = 0; i < w2.size(); ++i)
+			iw2[i] = std::llround(std::max(0.0, w2[i]) * scale);
+
+		getMWIS(iw1, iw2, g, in1, in2);
+
+		double total = 0.0;
+		for (size_t i = 0; i < w1.size(); ++i)
+			if (in1[i])
+				total += std::max(0.0, w1[i]);
+		for (size_t i = 0; i < w2.size(); ++i)
+			if (in2[i])
+				total += std::max(0.0, w2[i]);
+		return total;
+	}
+};
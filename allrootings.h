@@ -0,0 +1,259 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <cstdlib>
+
+#include "node.h"
+
+using namespace std;
+
+
+/**
+  Computes a statistic of every rooting of a tree, seen as unrooted, in O(n) calls to the statistic, by rerooting
+  dynamic programming.  A first pass summarizes each subtree, a second pass summarizes the complement of each
+  subtree (rooted at its parent), and the rooting on the edge above v joins the two sides of that edge.
+  The statistic is a class with:
+  - Value: the summary of a rooted subtree, default constructible
+  - Set: the summary of the children of a node, whose default value is the empty set
+  - Value leaf(Node* v): a leaf alone
+  - Set lift(const Value& t, double length): a child subtree hanging below an edge of this length
+  - Set combine(const Set& a, const Set& b): union of two children sets, which must be associative
+  - Value finalize(const Set& s, Node* v): node v with the children s.  v is nullptr for the root of a rooting.
+  Each node combines its neighbours with prefix and suffix combines, so the total cost is O(n) even with
+  high degree nodes.  A root with two children is not a node of the unrooted tree, so its two edges are seen as
+  one edge, whose length is the sum of theirs.  Other nodes with a single child are passed to finalize.
+  **/
+template <class Stat>
+class AllRootings {
+public:
+    typedef typename Stat::Value Value;
+    typedef typename Stat::Set Set;
+
+
+    /**
+      Returns, for the i-th node of tree in postorder, the value of the rooting on its parent edge, with the root at
+      distance ratio x (length of the parent edge) from the node, as TreeUtil::reroot_on_edge does.  The entry of
+      the root is Value().
+      The rootings are listed in the same order as all_reroots.
+      **/
+    static vector<Value> compute(Node* tree, Stat& stat, double ratio = 0.5) {
+        vector<Node*> nodes;
+        vector<Value> down, up;
+        vector<double> lengths;
+        compute_sides(tree, stat, nodes, down, up, lengths);
+
+        vector<Value> values(nodes.size());
+        for (size_t i = 0; i < nodes.size(); ++i) {
+            Node* v = nodes[i];
+            if (v->is_root())
+                continue;
+            double below = v->branch_length * ratio;
+            Set s = stat.combine(stat.lift(down[i], below), stat.lift(up[i], lengths[i] - below));
+            values[i] = stat.finalize(s, nullptr);
+        }
+
+        return values;
+    }
+
+
+
+    /**
+      The two sides of the parent edge of each node, for callers that need to place the root themselves: nodes is
+      the postorder of tree, down[i] is the subtree of nodes[i], up[i] the rest of the tree rooted at the other end
+      of the edge, and lengths[i] the length of the edge (for a child of a binary root, the sum of the two edges
+      of the root).
+      **/
+    static void compute_sides(Node* tree, Stat& stat, vector<Node*>& nodes, vector<Value>& down, vector<Value>& up,
+                              vector<double>& lengths) {
+        nodes = tree->get_postordered_nodes();
+        int n = nodes.size();
+        unordered_map<Node*, int> index;
+        for (int i = 0; i < n; ++i)
+            index[nodes[i]] = i;
+
+        bool binary_root = (tree->get_nb_children() == 2);
+        lengths.assign(n, 0.0);
+        for (int i = 0; i < n; ++i) {
+            Node* v = nodes[i];
+            if (v->is_root())
+                continue;
+            if (binary_root && v->get_parent() == tree)
+                lengths[i] = tree->get_child(0)->branch_length + tree->get_child(1)->branch_length;
+            else
+                lengths[i] = v->branch_length;
+        }
+
+        down.assign(n, Value());
+        up.assign(n, Value());
+        for (int i = 0; i < n; ++i) {
+            Node* g = nodes[i];
+            if (g->is_leaf()) {
+                down[i] = stat.leaf(g);
+                continue;
+            }
+            Set s;
+            for (int k = 0; k < g->get_nb_children(); ++k) {
+                Node* c = g->get_child(k);
+                s = stat.combine(s, stat.lift(down[index[c]], c->branch_length));
+            }
+            down[i] = stat.finalize(s, g);
+        }
+
+        //parents come before their children in reverse postorder
+        vector<Set> suffix;
+        for (int i = n - 1; i >= 0; --i) {
+            Node* g = nodes[i];
+            int nbchildren = g->get_nb_children();
+            if (nbchildren == 0)
+                continue;
+
+            suffix.assign(nbchildren + 1, Set());
+            for (int k = nbchildren - 1; k >= 0; --k) {
+                Node* c = g->get_child(k);
+                suffix[k] = stat.combine(stat.lift(down[index[c]], c->branch_length), suffix[k + 1]);
+            }
+
+            Set prefix;
+            if (!g->is_root())
+                prefix = stat.lift(up[i], lengths[i]);
+            for (int k = 0; k < nbchildren; ++k) {
+                Node* c = g->get_child(k);
+                int ci = index[c];
+                //a root with a single child is a leaf of the unrooted tree
+                if (g->is_root() && nbchildren == 1)
+                    up[ci] = stat.leaf(g);
+                else if (g->is_root() && nbchildren == 2)
+                    up[ci] = down[index[g->get_child(1 - k)]];
+                else
+                    up[ci] = stat.finalize(stat.combine(prefix, suffix[k + 1]), g);
+                prefix = stat.combine(prefix, stat.lift(down[ci], c->branch_length));
+            }
+        }
+    }
+};
+
+
+
+
+/**
+  Height of the tree: maximum distance from the root to a leaf (in edges if use_lengths is false).
+  **/
+class HeightStat {
+public:
+    typedef double Value;
+
+    struct Set {
+        bool empty = true;
+        double height = 0.0;
+    };
+
+    bool use_lengths;
+
+    HeightStat(bool use_lengths = true) : use_lengths(use_lengths) {}
+
+    Value leaf(Node* v) {
+        return 0.0;
+    }
+
+    Set lift(const Value& t, double length) {
+        return { false, t + (use_lengths ? length : 1.0) };
+    }
+
+    Set combine(const Set& a, const Set& b) {
+        if (a.empty)
+            return b;
+        if (b.empty)
+            return a;
+        return { false, max(a.height, b.height) };
+    }
+
+    Value finalize(const Set& s, Node* v) {
+        return s.height;
+    }
+};
+
+
+
+
+/**
+  Sum of the distances from the root to the leaves, and of their squares.  Without lengths, the sum is the Sackin
+  index (sum of leaf depths).
+  **/
+class PathLengthStat {
+public:
+    struct Value {
+        long long nb_leaves = 0;
+        double sum = 0.0;
+        double sum_squares = 0.0;
+    };
+    typedef Value Set;
+
+    bool use_lengths;
+
+    PathLengthStat(bool use_lengths = true) : use_lengths(use_lengths) {}
+
+    Value leaf(Node* v) {
+        return { 1, 0.0, 0.0 };
+    }
+
+    Set lift(const Value& t, double length) {
+        double l = (use_lengths ? length : 1.0);
+        return { t.nb_leaves, t.sum + t.nb_leaves * l, t.sum_squares + 2.0 * l * t.sum + t.nb_leaves * l * l };
+    }
+
+    Set combine(const Set& a, const Set& b) {
+        return { a.nb_leaves + b.nb_leaves, a.sum + b.sum, a.sum_squares + b.sum_squares };
+    }
+
+    Value finalize(const Set& s, Node* v) {
+        return s;
+    }
+};
+
+
+
+
+/**
+  Colless index: sum over the binary nodes of the difference between the number of leaves of their two subtrees.
+  Nodes of other degrees add nothing.
+  **/
+class CollessStat {
+public:
+    struct Value {
+        long long nb_leaves = 0;
+        long long colless = 0;
+    };
+
+    struct Set {
+        int nb_children = 0;
+        long long first = 0, second = 0;     //leaves of the first two children
+        long long nb_leaves = 0;
+        long long colless = 0;
+    };
+
+    Value leaf(Node* v) {
+        return { 1, 0 };
+    }
+
+    Set lift(const Value& t, double length) {
+        return { 1, t.nb_leaves, 0, t.nb_leaves, t.colless };
+    }
+
+    Set combine(const Set& a, const Set& b) {
+        if (a.nb_children == 0)
+            return b;
+        if (b.nb_children == 0)
+            return a;
+        Set s = { a.nb_children + b.nb_children, a.first, (a.nb_children >= 2 ? a.second : b.first),
+                  a.nb_leaves + b.nb_leaves, a.colless + b.colless };
+        return s;
+    }
+
+    Value finalize(const Set& s, Node* v) {
+        long long c = (s.nb_children == 2 ? llabs(s.first - s.second) : 0);
+        return { s.nb_leaves, s.colless + c };
+    }
+};
@@ -0,0 +1,441 @@
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <iomanip>
+#include <random>
+#include <sys/resource.h>
+
+#include "node.h"
+#include "util.h"
+#include "treepairinfo.h"
+#include "maxflowengines.h"
+#include "flowinstances.h"
+#include "treeutil.h"
+#include "treeperturb.h"
+#include "tbe.h"
+#include "patristic.h"
+
+using namespace std;
+
+
+
+
+
+double get_elapsed_ms(chrono::steady_clock::time_point start) {
+	return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+
+/**
+  Peak resident memory of the process, in MB.
+**/
+double get_peak_rss_mb() {
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	return usage.ru_maxrss / 1024.0;
+}
+
+
+
+
+
+/**
+  Builds the instance of the given kind, among random, grid, bipartite, treepair and file.
+  -n approximate number of vertices (default 100000), -l number of leaves for treepair (default 1000)
+  -c maximum capacity, at least 1 (default 1000, bipartite always uses unit capacities), -s seed (default 1)
+  -i incompatibility graph written by -m incompat -o, for the file kind
+  Returns false if the instance cannot be built.
+**/
+bool make_instance(const string& kind, map<string, string>& args, FlowInstance& inst) {
+	int n = 100000;
+	int nbleaves = 1000;
+	long long maxcap = 1000;
+	uint64 seed = 1;
+
+	if ((args.count("n") && !Util::ParseInt(args["n"], n)) || (args.count("l") && !Util::ParseInt(args["l"], nbleaves)) ||
+		(args.count("c") && !Util::ParseLongLong(args["c"], maxcap))) {
+		cout << "The values of -n, -l and -c must be integers" << endl;
+		return false;
+	}
+	if (args.count("s") && !Util::ParseUInt64(args["s"], seed)) {
+		cout << "The seed -s must be a non-negative integer" << endl;
+		return false;
+	}
+
+	//the source and the sink must differ, and the generators draw capacities and vertices modulo -c and -n
+	if (maxcap < 1) {
+		cout << "The maximum capacity -c must be at least 1" << endl;
+		return false;
+	}
+	int minn = (kind == "grid" ? 1 : 2);
+	if ((kind == "random" || kind == "grid" || kind == "bipartite") && n < minn) {
+		cout << "The number of vertices -n must be at least " << minn << " for " << kind << " instances" << endl;
+		return false;
+	}
+	if (kind == "treepair" && nbleaves < 4) {
+		cout << "The number of leaves -l must be at least 4 for treepair instances" << endl;
+		return false;
+	}
+
+	if (kind == "random")
+		inst = FlowInstanceGenerator::get_random_graph(n, 4 * n, maxcap, seed);
+	else if (kind == "grid") {
+		int side = 1;
+		while ((side + 1) * (side + 1) <= n)
+			side++;
+		inst = FlowInstanceGenerator::get_grid(side, side, maxcap, seed);
+	}
+	else if (kind == "bipartite")
+		inst = FlowInstanceGenerator::get_bipartite(n / 2, n / 2, 3, 1, seed);
+	else if (kind == "treepair")
+		inst = FlowInstanceGenerator::get_tree_pair(nbleaves, maxcap, seed);
+	else if (kind == "file") {
+		IncompatGraph g;
+		if (!args.count("i") || !g.read_binary(args["i"])) {
+			cout << "Please specify an incompatibility graph file with -i [filename]" << endl;
+			return false;
+		}
+		inst = FlowInstanceGenerator::get_incompat_network(g, maxcap, seed);
+		inst.name = "file";
+	}
+	else {
+		cout << "Unknown instance kind " << kind << endl;
+		return false;
+	}
+
+	return true;
+}
+
+
+
+
+
+/**
+  Runs every requested max-flow engine on every requested instance, and reports the build time (edges insertion),
+  the solve time, the memory used by the engine and the peak memory of the process.  Flow values are checked to agree.
+  -g instance kinds, comma separated (default: random,grid,bipartite,treepair), see make_instance for their options
+  -e engines, comma separated (default: all)
+  -r repetitions (default 3)
+**/
+void exec_bench_maxflow(map<string, string>& args) {
+	vector<string> kinds = { "random", "grid", "bipartite", "treepair" };
+	vector<string> engines = MaxFlowEngines::get_names();
+	int nbreps = 3;
+
+	if (args.count("g"))
+		kinds = Util::Split(args["g"], ",", false);
+	if (args.count("e"))
+		engines = Util::Split(args["e"], ",", false);
+	if (args.count("r"))
+		nbreps = Util::ToInt(args["r"]);
+
+	cout << left << setw(12) << "instance" << setw(10) << "n" << setw(12) << "m" << setw(14) << "engine"
+		<< setw(12) << "build_ms" << setw(12) << "solve_ms" << setw(12) << "engine_mb" << setw(12) << "peak_rss_mb"
+		<< "flow" << endl;
+
+	for (string kind : kinds) {
+		FlowInstance inst;
+		if (!make_instance(kind, args, inst))
+			continue;
+
+		long long reference = -1;
+		for (string name : engines) {
+			for (int rep = 0; rep < nbreps; ++rep) {
+				auto start = chrono::steady_clock::now();
+				MaxFlowSolver* flow = MaxFlowEngines::create(name, inst.n);
+				if (!flow) {
+					cout << "Unknown engine " << name << endl;
+					break;
+				}
+				inst.load_into(*flow);
+				double build_ms = get_elapsed_ms(start);
+
+				start = chrono::steady_clock::now();
+				long long value = flow->max_flow(inst.source, inst.sink);
+				double solve_ms = get_elapsed_ms(start);
+
+				if (reference == -1)
+					reference = value;
+
+				cout << left << setw(12) << inst.name << setw(10) << inst.n << setw(12) << inst.from.size()
+					<< setw(14) << name << setw(12) << fixed << setprecision(2) << build_ms << setw(12) << solve_ms
+					<< setw(12) << flow->get_memory_usage() / (1024.0 * 1024.0) << setw(12) << get_peak_rss_mb()
+					<< value << (value != reference ? "  MISMATCH" : "") << endl;
+
+				delete flow;
+			}
+		}
+	}
+}
+
+
+
+
+
+/**
+  Sequences of related instances: each round changes the capacity of -u edges (default 10) and inserts -a new
+  edges (default 1), then PushRelabel::reoptimize is timed against a cold PushRelabel solve of the same instance.
+  On the MWIS-like kinds (bipartite, treepair, file) only terminal edges are changed, which amounts to re-weighting
+  clades, and insertions link a random V1 vertex to a random V2 vertex.
+  -g instance kinds (default: grid,bipartite,treepair), -k rounds (default 20), see make_instance for the other options
+**/
+void exec_bench_incremental(map<string, string>& args) {
+	vector<string> kinds = { "grid", "bipartite", "treepair" };
+	int nbrounds = 20;
+	int nbupdates = 10;
+	int nbinserts = 1;
+
+	if (args.count("g"))
+		kinds = Util::Split(args["g"], ",", false);
+	if (args.count("k"))
+		nbrounds = Util::ToInt(args["k"]);
+	if (args.count("u"))
+		nbupdates = Util::ToInt(args["u"]);
+	if (args.count("a"))
+		nbinserts = Util::ToInt(args["a"]);
+
+	cout << left << setw(12) << "instance" << setw(10) << "n" << setw(12) << "m" << setw(10) << "rounds"
+		<< setw(14) << "first_ms" << setw(14) << "warm_avg_ms" << setw(14) << "cold_avg_ms" << "speedup" << endl;
+
+	for (string kind : kinds) {
+		FlowInstance inst;
+		if (!make_instance(kind, args, inst))
+			continue;
+
+		bool terminal_only = (kind != "random" && kind != "grid");
+		vector<int> candidates;
+		for (size_t e = 0; e < inst.from.size(); ++e) {
+			if (!terminal_only || inst.from[e] == inst.source || inst.to[e] == inst.sink)
+				candidates.push_back(e);
+		}
+		long long maxcap = 1;
+		for (size_t e : candidates)
+			maxcap = max(maxcap, inst.caps[e]);
+		long long inf = 1;
+		for (long long c : inst.caps)
+			inf = max(inf, c);
+
+		mt19937_64 rng(7);
+
+		auto start = chrono::steady_clock::now();
+		PushRelabel warm(inst.n);
+		inst.load_into(warm);
+		warm.max_flow(inst.source, inst.sink);
+		double first_ms = get_elapsed_ms(start);
+
+		double warm_ms = 0.0;
+		double cold_ms = 0.0;
+		int nbmismatches = 0;
+		for (int round = 0; round < nbrounds; ++round) {
+			for (int k = 0; k < nbupdates; ++k) {
+				int e = candidates[rng() % candidates.size()];
+				inst.caps[e] = 1 + rng() % maxcap;
+			}
+			for (int k = 0; k < nbinserts; ++k) {
+				if (terminal_only)
+					inst.add_edge(inst.from[candidates[rng() % candidates.size()]], inst.to[candidates[rng() % candidates.size()]], inf);
+				else
+					inst.add_edge(rng() % inst.n, rng() % inst.n, 1 + rng() % maxcap);
+			}
+
+			start = chrono::steady_clock::now();
+			size_t nbold = warm.get_nb_edges();
+			for (size_t e = nbold; e < inst.from.size(); ++e)
+				warm.addEdge(inst.from[e], inst.to[e], inst.caps[e]);
+			for (size_t e = 0; e < nbold; ++e) {
+				if (warm.edge_cap[e] != inst.caps[e])
+					warm.set_capacity(e, inst.caps[e]);
+			}
+			long long warm_value = warm.reoptimize();
+			warm_ms += get_elapsed_ms(start);
+
+			start = chrono::steady_clock::now();
+			PushRelabel cold(inst.n);
+			inst.load_into(cold);
+			long long cold_value = cold.max_flow(inst.source, inst.sink);
+			cold_ms += get_elapsed_ms(start);
+
+			if (warm_value != cold_value)
+				nbmismatches++;
+		}
+
+		cout << left << setw(12) << inst.name << setw(10) << inst.n << setw(12) << inst.from.size() << setw(10) << nbrounds
+			<< setw(14) << fixed << setprecision(2) << first_ms << setw(14) << warm_ms / nbrounds
+			<< setw(14) << cold_ms / nbrounds << cold_ms / max(warm_ms, 1e-9)
+			<< (nbmismatches > 0 ? "  MISMATCH" : "") << endl;
+	}
+}
+
+
+
+
+
+/**
+  Transfer bootstrap expectation: compares TransferSupport::add_replicate to the quadratic add_replicate_naive on a
+  random reference tree and perturbed replicates, and checks that they give the same transfer distances.
+  -l number of leaves (default 10000), -r replicates (default 5), -k SPR moves per replicate (default 100),
+  -g reference tree model (default uniform, see TreeUtil::get_random_tree), -s seed (default 1)
+**/
+void exec_bench_tbe(map<string, string>& args) {
+	int nbleaves = 10000;
+	int nbreps = 5;
+	int nbmoves = 100;
+	string model = "uniform";
+	uint64 seed = 1;
+
+	if (args.count("l"))
+		nbleaves = Util::ToInt(args["l"]);
+	if (args.count("r"))
+		nbreps = Util::ToInt(args["r"]);
+	if (args.count("k"))
+		nbmoves = Util::ToInt(args["k"]);
+	if (args.count("g"))
+		model = args["g"];
+	if (args.count("s") && !Util::ParseUInt64(args["s"], seed)) {
+		cout << "The seed -s must be a non-negative integer" << endl;
+		return;
+	}
+
+	Rng rng(seed);
+	Node* reference = new Node();
+	if (!TreeUtil::get_random_tree(reference, nbleaves, model, rng)) {
+		cout << "Unknown model " << model << " or invalid number of leaves -l" << endl;
+		delete reference;
+		return;
+	}
+	TransferSupport support(reference);
+
+	cout << left << setw(10) << "n" << setw(10) << "branches" << setw(12) << "replicate" << setw(14) << "fast_ms"
+		<< setw(14) << "naive_ms" << "speedup" << endl;
+
+	for (int rep = 0; rep < nbreps; ++rep) {
+		Node* tree = new Node(*reference);
+		TreePerturber perturber(tree, rng);
+		perturber.perturb(nbmoves, "spr");
+
+		vector<double> fast(support.get_nb_queries(), 0.0);
+		vector<double> naive(support.get_nb_queries(), 0.0);
+
+		auto start = chrono::steady_clock::now();
+		support.add_replicate(tree, fast);
+		double fast_ms = get_elapsed_ms(start);
+
+		start = chrono::steady_clock::now();
+		support.add_replicate_naive(tree, naive);
+		double naive_ms = get_elapsed_ms(start);
+
+		cout << left << setw(10) << nbleaves << setw(10) << support.get_nb_queries() << setw(12) << rep
+			<< setw(14) << fixed << setprecision(2) << fast_ms << setw(14) << naive_ms << naive_ms / max(fast_ms, 1e-9)
+			<< (fast != naive ? "  MISMATCH" : "") << endl;
+
+		delete tree;
+	}
+
+	delete reference;
+}
+
+
+
+
+
+/**
+  Compares the rows of the leaf distance matrix of PatristicDistances (one upward walk per leaf) with n^2
+  independent LCA-based queries, on random trees with random branch lengths, and checks that both agree.
+  -l number of leaves (default 5000), -r repetitions (default 3), -g tree model (default uniform), -s seed
+**/
+void exec_bench_patristic(map<string, string>& args) {
+	int nbleaves = 5000;
+	int nbreps = 3;
+	string model = "uniform";
+	uint64 seed = 1;
+
+	if (args.count("l"))
+		nbleaves = Util::ToInt(args["l"]);
+	if (args.count("r"))
+		nbreps = Util::ToInt(args["r"]);
+	if (args.count("g"))
+		model = args["g"];
+	if (args.count("s") && !Util::ParseUInt64(args["s"], seed)) {
+		cout << "The seed -s must be a non-negative integer" << endl;
+		return;
+	}
+
+	Rng rng(seed);
+
+	cout << left << setw(10) << "n" << setw(12) << "replicate" << setw(14) << "rows_ms" << setw(14) << "queries_ms"
+		<< "speedup" << endl;
+
+	for (int rep = 0; rep < nbreps; ++rep) {
+		Node* tree = new Node();
+		if (!TreeUtil::get_random_tree(tree, nbleaves, model, rng)) {
+			cout << "Unknown model " << model << " or invalid number of leaves -l" << endl;
+			delete tree;
+			return;
+		}
+		TreeUtil::randomize_branch_lengths(tree, 0.01, 1.0, rng);
+		PatristicDistances pd(tree);
+		int k = pd.get_nb_leaves();
+		const LCAIndex& index = pd.get_index();
+
+		vector<int> ids;
+		for (int i = 0; i < k; ++i)
+			ids.push_back(index.get_id(pd.get_leaf(i)));
+
+		vector<double> row(k);
+		double checksum_rows = 0.0;
+		auto start = chrono::steady_clock::now();
+		for (int i = 0; i < k; ++i) {
+			pd.fill_row(i, row.data());
+			for (int j = 0; j < k; ++j)
+				checksum_rows += row[j];
+		}
+		double rows_ms = get_elapsed_ms(start);
+
+		double checksum_queries = 0.0;
+		start = chrono::steady_clock::now();
+		for (int i = 0; i < k; ++i) {
+			for (int j = 0; j < k; ++j)
+				checksum_queries += pd.get_distance(ids[i], ids[j]);
+		}
+		double queries_ms = get_elapsed_ms(start);
+
+		bool mismatch = fabs(checksum_rows - checksum_queries) > 1e-9 * max(1.0, fabs(checksum_queries));
+		cout << left << setw(10) << k << setw(12) << rep << setw(14) << fixed << setprecision(2) << rows_ms
+			<< setw(14) << queries_ms << queries_ms / max(rows_ms, 1e-9) << (mismatch ? "  MISMATCH" : "") << endl;
+
+		delete tree;
+	}
+}
+
+
+
+
+
+int main(int argc, char** argv) {
+
+	map<string, string> args = Util::ParseArguments(argc, argv);
+
+	string mode = "maxflow";
+	if (args.count("m"))
+		mode = args["m"];
+
+	if (mode == "maxflow") {
+		exec_bench_maxflow(args);
+	}
+	else if (mode == "incremental") {
+		exec_bench_incremental(args);
+	}
+	else if (mode == "tbe") {
+		exec_bench_tbe(args);
+	}
+	else if (mode == "patristic") {
+		exec_bench_patristic(args);
+	}
+	else {
+		cout << "Unknown benchmark " << mode << endl;
+	}
+
+	return 0;
+}
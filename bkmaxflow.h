@@ -0,0 +1,323 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+
+#include "maxflow.h"
+
+using namespace std;
+
+
+/**
+  Boykov-Kolmogorov max-flow (An Experimental Comparison of Min-Cut/Max-Flow Algorithms for Energy Minimization in Vision, 2004).
+  Two search trees grow from the source and the sink, and are reused from one augmentation to the next instead of being
+  rebuilt like in Dinic.  Orphans created by saturations look for a new parent, preferring the ones closest to their
+  terminal (timestamp and distance heuristics).  No good worst-case bound, but very fast on graphs with short
+  augmenting paths such as grids and the bipartite incompatibility networks.
+  **/
+struct BoykovKolmogorov : public MaxFlowSolver
+{
+	static constexpr int FREE = 0;
+	static constexpr int S_TREE = 1;
+	static constexpr int T_TREE = 2;
+
+	static constexpr int NO_PARENT = -1;
+	static constexpr int TERMINAL = -2;
+	static constexpr int ORPHAN = -3;
+
+	vector<int> tree;
+	vector<int> parent_arc;	//arc from a vertex to its parent in its tree
+	vector<int> timestamp;
+	vector<int> dist;
+	vector<bool> in_active;
+	vector<int> active;
+	size_t active_pos;
+	vector<int> orphans;
+	int time;
+
+	long long nb_augmentations;
+
+
+	BoykovKolmogorov(int n) :
+		MaxFlowSolver(n) {}
+
+
+	string get_name()
+	{
+		return "bk";
+	}
+
+
+
+	void set_active(int v)
+	{
+		if (!in_active[v])
+		{
+			in_active[v] = true;
+			active.push_back(v);
+		}
+	}
+
+
+	/**
+	  Residual capacity of arc a in the direction of the tree growth: from parent to child in the source tree,
+	  from child to parent in the sink tree.
+	  **/
+	long long tree_cap(int a, int t)
+	{
+		return (t == S_TREE ? rescap[a] : rescap[rev[a]]);
+	}
+
+
+
+	/**
+	  Grows the trees from the active vertices until they touch.  Returns the arc from the source tree to the
+	  sink tree, or -1 if the trees cannot grow anymore.
+	  **/
+	int grow()
+	{
+		while (active_pos < active.size())
+		{
+			if (active_pos > 4096 && 2 * active_pos > active.size())
+			{
+				active.erase(active.begin(), active.begin() + active_pos);
+				active_pos = 0;
+			}
+
+			int p = active[active_pos];
+			if (tree[p] != FREE)
+			{
+				for (int a = first_arc[p]; a < first_arc[p + 1]; ++a)
+				{
+					if (tree_cap(a, tree[p]) == 0)
+						continue;
+
+					int q = head[a];
+					if (tree[q] == FREE)
+					{
+						tree[q] = tree[p];
+						parent_arc[q] = rev[a];
+						timestamp[q] = timestamp[p];
+						dist[q] = dist[p] + 1;
+						set_active(q);
+					}
+					else if (tree[q] != tree[p])
+					{
+						return (tree[p] == S_TREE ? a : rev[a]);
+					}
+					else if (timestamp[q] <= timestamp[p] && dist[q] > dist[p])
+					{
+						//q gets a parent closer to the terminal
+						parent_arc[q] = rev[a];
+						timestamp[q] = timestamp[p];
+						dist[q] = dist[p] + 1;
+					}
+				}
+			}
+
+			in_active[p] = false;
+			active_pos++;
+		}
+
+		active.clear();
+		active_pos = 0;
+		return -1;
+	}
+
+
+
+	long long augment(int meet)
+	{
+		int x = head[rev[meet]];
+		int y = head[meet];
+
+		long long amt = rescap[meet];
+		for (int v = x; parent_arc[v] != TERMINAL; v = head[parent_arc[v]])
+			amt = min(amt, rescap[rev[parent_arc[v]]]);
+		for (int v = y; parent_arc[v] != TERMINAL; v = head[parent_arc[v]])
+			amt = min(amt, rescap[parent_arc[v]]);
+
+		rescap[meet] -= amt;
+		rescap[rev[meet]] += amt;
+
+		for (int v = x; parent_arc[v] != TERMINAL; )
+		{
+			int a = parent_arc[v];
+			int p = head[a];
+			rescap[rev[a]] -= amt;
+			rescap[a] += amt;
+			if (rescap[rev[a]] == 0)
+			{
+				parent_arc[v] = ORPHAN;
+				orphans.push_back(v);
+			}
+			v = p;
+		}
+		for (int v = y; parent_arc[v] != TERMINAL; )
+		{
+			int a = parent_arc[v];
+			int p = head[a];
+			rescap[a] -= amt;
+			rescap[rev[a]] += amt;
+			if (rescap[a] == 0)
+			{
+				parent_arc[v] = ORPHAN;
+				orphans.push_back(v);
+			}
+			v = p;
+		}
+
+		nb_augmentations++;
+		return amt;
+	}
+
+
+
+	/**
+	  Distance from q to its terminal, or -1 if q descends from an orphan.  Vertices whose distance
+	  is known for the current time are not walked again.
+	  **/
+	int get_origin_dist(int q)
+	{
+		int d = 0;
+		int v = q;
+		while (true)
+		{
+			if (timestamp[v] == time)
+			{
+				d += dist[v];
+				break;
+			}
+			if (parent_arc[v] == TERMINAL)
+			{
+				timestamp[v] = time;
+				dist[v] = 1;
+				d += 1;
+				break;
+			}
+			if (parent_arc[v] == ORPHAN || parent_arc[v] == NO_PARENT)
+				return -1;
+			d++;
+			v = head[parent_arc[v]];
+		}
+
+		//cache the distances along the path
+		for (int u = q; timestamp[u] != time; u = head[parent_arc[u]])
+		{
+			timestamp[u] = time;
+			dist[u] = d;
+			d--;
+		}
+
+		return dist[q];
+	}
+
+
+
+	void adopt()
+	{
+		while (!orphans.empty())
+		{
+			int v = orphans.back();
+			orphans.pop_back();
+			int t = tree[v];
+
+			int best_arc = -1;
+			int best_dist = 0;
+			for (int a = first_arc[v]; a < first_arc[v + 1]; ++a)
+			{
+				int q = head[a];
+				//the arc must carry flow from q to v in the source tree, from v to q in the sink tree
+				if (tree[q] != t || tree_cap(rev[a], t) == 0)
+					continue;
+
+				int d = get_origin_dist(q);
+				if (d != -1 && (best_arc == -1 || d < best_dist))
+				{
+					best_arc = a;
+					best_dist = d;
+				}
+			}
+
+			if (best_arc != -1)
+			{
+				parent_arc[v] = best_arc;
+				timestamp[v] = time;
+				dist[v] = best_dist + 1;
+				continue;
+			}
+
+			//no parent: v becomes free, its children become orphans and its neighbours may grow over it
+			for (int a = first_arc[v]; a < first_arc[v + 1]; ++a)
+			{
+				int q = head[a];
+				if (tree[q] != t)
+					continue;
+				if (tree_cap(rev[a], t) > 0)
+					set_active(q);
+				if (parent_arc[q] >= 0 && head[parent_arc[q]] == v)
+				{
+					parent_arc[q] = ORPHAN;
+					orphans.push_back(q);
+				}
+			}
+			tree[v] = FREE;
+			parent_arc[v] = NO_PARENT;
+		}
+	}
+
+
+
+	long long max_flow(int source, int dest)
+	{
+		this->source = source;
+		this->sink = dest;
+		nb_augmentations = 0;
+
+		reset_residual();
+
+		if (source == dest)
+			return 0;
+
+		tree.assign(n, FREE);
+		parent_arc.assign(n, NO_PARENT);
+		timestamp.assign(n, 0);
+		dist.assign(n, 0);
+		in_active.assign(n, false);
+		active.clear();
+		active_pos = 0;
+		orphans.clear();
+		time = 0;
+
+		tree[source] = S_TREE;
+		tree[sink] = T_TREE;
+		parent_arc[source] = parent_arc[sink] = TERMINAL;
+		dist[source] = dist[sink] = 1;
+		set_active(source);
+		set_active(sink);
+
+		long long flow = 0;
+		while (true)
+		{
+			int meet = grow();
+			if (meet == -1)
+				break;
+
+			//the active vertex being processed stays in the queue for the next growth
+			time++;
+			flow += augment(meet);
+			adopt();
+		}
+
+		return flow;
+	}
+
+
+
+	size_t get_memory_usage()
+	{
+		return MaxFlowSolver::get_memory_usage() + in_active.capacity() / 8 +
+			(tree.capacity() + parent_arc.capacity() + timestamp.capacity() + dist.capacity() +
+			active.capacity() + orphans.capacity()) * sizeof(int);
+	}
+};
@@ -0,0 +1,291 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <cmath>
+
+#include "node.h"
+#include "util.h"
+#include "rfdistance.h"
+#include "treepairinfo.h"
+
+using namespace std;
+
+
+/**
+  Consensus of a stream of trees on the same leaf set: strict (splits found in all trees), majority (splits found
+  in more than a fraction t >= 0.5 of the trees) or greedy, a.k.a. extended majority (all splits by decreasing
+  frequency, each kept if compatible with the ones kept before).
+  Splits are counted by their BipartitionHasher hash, and the first time a split is met its leaf set is stored
+  as a bitmap (for unrooted trees, the side that does not contain leaf 0).  Adding a tree is O(n), plus the size
+  of its new splits.
+  The number of distinct splits can be bounded with min_frequency = e > 0 (lossy counting, Manku and Motwani):
+  every 1/e trees, splits whose count is too small to reach e of the trees are dropped.  Counts are then
+  underestimated by at most e x (number of trees), every split above that frequency is kept, and at most
+  O(log(e N) / e) splits are stored.
+  **/
+class ConsensusBuilder {
+public:
+    BipartitionHasher hasher;
+    bool rooted;
+    double min_frequency;
+
+    ConsensusBuilder(bool rooted = false, double min_frequency = 0.0) : rooted(rooted), min_frequency(min_frequency) {}
+
+
+
+    /**
+      Counts the splits of tree.  Returns false (and ignores the tree) if its leaf set differs from the first tree.
+      **/
+    bool add_tree(Node* tree) {
+        vector<uint64> hashes;
+        vector<pair<int, int>> ranges;
+        vector<int> leaf_order;
+        uint64 total = 0;
+        int n = hasher.get_splits(tree, rooted, hashes, total, &ranges, &leaf_order);
+
+        if (nbtrees == 0) {
+            nbleaves = n;
+            leafset = total;
+        }
+        else if (n != nbleaves || total != leafset) {
+            return false;
+        }
+        nbtrees++;
+
+        long long bucket = 0;
+        if (min_frequency > 0.0)
+            bucket = (nbtrees - 1) / get_bucket_width() + 1;
+
+        for (size_t i = 0; i < hashes.size(); ++i) {
+            auto it = table.find(hashes[i]);
+            if (it != table.end()) {
+                //a tree may have the same split twice, e.g. a bipartition split by a degree 2 node
+                if (it->second.last_tree != nbtrees) {
+                    it->second.count++;
+                    it->second.last_tree = nbtrees;
+                }
+                continue;
+            }
+
+            SplitCount& sc = table[hashes[i]];
+            sc.count = 1;
+            sc.delta = (bucket > 0 ? bucket - 1 : 0);
+            sc.last_tree = nbtrees;
+            sc.side = get_side(ranges[i].first, ranges[i].second, leaf_order);
+        }
+
+        if (min_frequency > 0.0 && nbtrees % get_bucket_width() == 0) {
+            for (auto it = table.begin(); it != table.end(); ) {
+                if (it->second.count + it->second.delta <= bucket)
+                    it = table.erase(it);
+                else
+                    ++it;
+            }
+        }
+
+        return true;
+    }
+
+
+    long long get_nb_trees() {
+        return nbtrees;
+    }
+
+
+    size_t get_nb_stored_splits() {
+        return table.size();
+    }
+
+
+
+    /**
+      Builds the consensus tree with the given method (strict, majority or greedy).  For majority, splits must be
+      in more than threshold x (number of trees) trees.  Internal nodes are labelled by the frequency of their split.
+      Unrooted consensus trees are rooted on the parent of leaf 0.  Takes O(total size of the candidate splits),
+      plus sorting them by frequency.  User has to delete returned value.
+      **/
+    Node* get_consensus(const string& method, double threshold = 0.5) {
+        vector<pair<long long, uint64>> order;
+        for (auto& entry : table) {
+            long long count = entry.second.count;
+            bool keep = (method == "strict" ? count == nbtrees :
+                         method == "majority" ? count > threshold * nbtrees : true);
+            if (keep)
+                order.push_back(make_pair(count, entry.first));
+        }
+        sort(order.begin(), order.end(), [](const pair<long long, uint64>& a, const pair<long long, uint64>& b) {
+            return a.first > b.first || (a.first == b.first && a.second < b.second);
+        });
+
+        //leaves are 0..n-1, the root is n, and the parent of a node is fixed when a split is inserted above it
+        int n = nbleaves;
+        vector<int> parent(n + 1, n);
+        vector<int> size(n + 1, 1);
+        vector<long long> counts(n + 1, 0);
+        parent[n] = -1;
+        size[n] = n;
+
+        vector<char> visited(n + 1, 0);
+        vector<int> touched, tops;
+        for (auto& o : order) {
+            vector<size_t> leaves = table[o.second].side.toArray();
+            if (insert_clade(leaves, parent, size, visited, touched, tops))
+                counts.push_back(o.first);
+        }
+
+        return build_tree(parent, counts);
+    }
+
+
+
+private:
+    struct SplitCount {
+        long long count;
+        long long delta;
+        long long last_tree;
+        bitmap side;
+    };
+
+    int nbleaves = 0;
+    uint64 leafset = 0;
+    long long nbtrees = 0;
+    unordered_map<uint64, SplitCount> table;
+
+
+    long long get_bucket_width() {
+        return (long long)ceil(1.0 / min_frequency);
+    }
+
+
+
+    /**
+      Leaf set of the clade at positions [first, first + size) of leaf_order, or of its complement if the trees
+      are unrooted and the clade contains leaf 0.
+      **/
+    bitmap get_side(int first, int size, const vector<int>& leaf_order) {
+        vector<int> ids;
+        bool has_zero = false;
+        for (int i = first; i < first + size; ++i) {
+            ids.push_back(leaf_order[i]);
+            has_zero = has_zero || leaf_order[i] == 0;
+        }
+
+        if (!rooted && has_zero) {
+            ids.clear();
+            for (int i = 0; i < (int)leaf_order.size(); ++i) {
+                if (i < first || i >= first + size)
+                    ids.push_back(leaf_order[i]);
+            }
+        }
+
+        sort(ids.begin(), ids.end());
+        bitmap side;
+        for (int id : ids)
+            side.set(id);
+        return side;
+    }
+
+
+
+    /**
+      Inserts the clade in the laminar family given by parent, if it is compatible with it.  Every node has at
+      least 2 children, so sizes increase towards the root.  Each leaf climbs while the parent of its current node
+      is not larger than the clade, and stops at nodes already visited, so each node is visited once.  The nodes
+      where the climbs end are the tops: the clade is compatible iff their sizes add up to its size and they all
+      have the same parent, in which case they are moved under a new node.  A compatible clade visits fewer than
+      2 |leaves| nodes, so the climbs are abandoned past that.  O(|leaves|).
+      **/
+    bool insert_clade(const vector<size_t>& leaves, vector<int>& parent, vector<int>& size, vector<char>& visited,
+                      vector<int>& touched, vector<int>& tops) {
+        int k = leaves.size();
+        touched.clear();
+        tops.clear();
+        bool ok = true;
+        for (size_t leaf : leaves) {
+            int u = leaf;
+            visited[u] = 1;
+            touched.push_back(u);
+            while (parent[u] != -1 && size[parent[u]] <= k && !visited[parent[u]]) {
+                u = parent[u];
+                visited[u] = 1;
+                touched.push_back(u);
+            }
+            if (parent[u] == -1 || size[parent[u]] > k)
+                tops.push_back(u);
+
+            if ((int)touched.size() >= 2 * k) {
+                ok = false;
+                break;
+            }
+        }
+
+        long long covered = 0;
+        for (int u : tops) {
+            covered += size[u];
+            ok = ok && parent[u] == parent[tops[0]];
+        }
+
+        //a single top is a clade that already exists
+        ok = ok && covered == k && tops.size() >= 2 && parent[tops[0]] != -1;
+
+        if (ok) {
+            int w = parent.size();
+            parent.push_back(parent[tops[0]]);
+            size.push_back(k);
+            visited.push_back(0);
+            for (int u : tops)
+                parent[u] = w;
+        }
+
+        for (int u : touched)
+            visited[u] = 0;
+
+        return ok;
+    }
+
+
+
+    /**
+      Materializes the tree given by parent (node n is the root), without recursion.
+      **/
+    Node* build_tree(const vector<int>& parent, const vector<long long>& counts) {
+        int nbnodes = parent.size();
+        vector<int> child_offsets(nbnodes + 1, 0);
+        for (int u = 0; u < nbnodes; ++u) {
+            if (parent[u] != -1)
+                child_offsets[parent[u] + 1]++;
+        }
+        for (int u = 0; u < nbnodes; ++u)
+            child_offsets[u + 1] += child_offsets[u];
+        vector<int> children(nbnodes);
+        vector<int> fill_pos(child_offsets.begin(), child_offsets.end() - 1);
+        for (int u = 0; u < nbnodes; ++u) {
+            if (parent[u] != -1)
+                children[fill_pos[parent[u]]++] = u;
+        }
+
+        Node* root = new Node();
+        vector<pair<int, Node*>> stack;
+        stack.push_back(make_pair(nbleaves, root));
+        while (!stack.empty()) {
+            int u = stack.back().first;
+            Node* v = stack.back().second;
+            stack.pop_back();
+
+            if (u < nbleaves) {
+                v->label = hasher.leafid_to_label[u];
+                continue;
+            }
+            if (u != nbleaves)
+                v->label = Util::ToString((double)counts[u] / nbtrees);
+
+            for (int i = child_offsets[u]; i < child_offsets[u + 1]; ++i)
+                stack.push_back(make_pair(children[i], v->add_child()));
+        }
+
+        return root;
+    }
+};
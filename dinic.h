@@ -0,0 +1,149 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+
+#include "maxflow.h"
+
+using namespace std;
+
+
+/**
+  Dinic's algorithm: BFS levels from the source, then blocking flows by depth-first search along the level graph
+  with current arcs.  O(V^2 E) in general, but O(E sqrt(V)) on unit capacity networks, which makes it a good fit
+  for the near-unit bipartite incompatibility networks.  The DFS is iterative, so long augmenting paths are fine.
+  **/
+struct Dinic : public MaxFlowSolver
+{
+	vector<int> level;
+	vector<int> cur_arc;
+
+	long long nb_phases, nb_augmentations;
+
+
+	Dinic(int n) :
+		MaxFlowSolver(n) {}
+
+
+	string get_name()
+	{
+		return "dinic";
+	}
+
+
+
+	bool bfs()
+	{
+		level.assign(n, -1);
+		vector<int> queue;
+		queue.reserve(n);
+		queue.push_back(source);
+		level[source] = 0;
+		for (size_t q = 0; q < queue.size() && level[sink] == -1; ++q)
+		{
+			int u = queue[q];
+			for (int a = first_arc[u]; a < first_arc[u + 1]; ++a)
+			{
+				int w = head[a];
+				if (level[w] == -1 && rescap[a] > 0)
+				{
+					level[w] = level[u] + 1;
+					queue.push_back(w);
+				}
+			}
+		}
+		return level[sink] != -1;
+	}
+
+
+
+	/**
+	  Saturates the level graph.  path holds the arcs from the source to the current vertex v.
+	  **/
+	long long blocking_flow()
+	{
+		long long total = 0;
+		vector<int> path;
+		int v = source;
+
+		while (true)
+		{
+			if (v == sink)
+			{
+				long long amt = rescap[path[0]];
+				for (int a : path)
+					amt = min(amt, rescap[a]);
+
+				//retreat to the tail of the first saturated arc
+				size_t first_saturated = path.size();
+				for (size_t i = 0; i < path.size(); ++i)
+				{
+					rescap[path[i]] -= amt;
+					rescap[rev[path[i]]] += amt;
+					if (rescap[path[i]] == 0 && first_saturated == path.size())
+						first_saturated = i;
+				}
+				total += amt;
+				nb_augmentations++;
+
+				v = head[rev[path[first_saturated]]];
+				path.resize(first_saturated);
+				continue;
+			}
+
+			int end = first_arc[v + 1];
+			int& a = cur_arc[v];
+			while (a < end && (rescap[a] == 0 || level[head[a]] != level[v] + 1))
+				++a;
+
+			if (a < end)
+			{
+				path.push_back(a);
+				v = head[a];
+			}
+			else
+			{
+				//dead end, v is removed from the level graph
+				level[v] = -1;
+				if (path.empty())
+					break;
+				v = head[rev[path.back()]];
+				path.pop_back();
+				cur_arc[v]++;
+			}
+		}
+
+		return total;
+	}
+
+
+
+	long long max_flow(int source, int dest)
+	{
+		this->source = source;
+		this->sink = dest;
+		nb_phases = nb_augmentations = 0;
+
+		reset_residual();
+
+		if (source == dest)
+			return 0;
+
+		long long flow = 0;
+		while (bfs())
+		{
+			nb_phases++;
+			cur_arc.assign(first_arc.begin(), first_arc.end() - 1);
+			flow += blocking_flow();
+		}
+
+		return flow;
+	}
+
+
+
+	size_t get_memory_usage()
+	{
+		return MaxFlowSolver::get_memory_usage() + (level.capacity() + cur_arc.capacity()) * sizeof(int);
+	}
+};
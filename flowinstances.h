@@ -0,0 +1,172 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <random>
+#include <cstdlib>
+
+#include "maxflow.h"
+#include "node.h"
+#include "treeutil.h"
+#include "treepairinfo.h"
+#include "BipartiteMWIS.h"
+
+using namespace std;
+
+
+/**
+  A max-flow instance, as a list of edges.
+  **/
+struct FlowInstance {
+    string name;
+    int n = 0;
+    int source = 0;
+    int sink = 0;
+    vector<int> from;
+    vector<int> to;
+    vector<long long> caps;
+
+
+    void add_edge(int u, int v, long long cap) {
+        from.push_back(u);
+        to.push_back(v);
+        caps.push_back(cap);
+    }
+
+    void load_into(MaxFlowSolver& flow) {
+        for (size_t e = 0; e < from.size(); ++e)
+            flow.addEdge(from[e], to[e], caps[e]);
+    }
+};
+
+
+
+
+/**
+  Generators of representative max-flow instances.  All of them are deterministic given the seed.
+  **/
+class FlowInstanceGenerator {
+public:
+
+    /**
+      n vertices, m edges between uniformly chosen endpoints, capacities uniform in [1, maxcap].
+      **/
+    static FlowInstance get_random_graph(int n, int m, long long maxcap, uint64 seed) {
+        mt19937_64 rng(seed);
+        FlowInstance inst;
+        inst.name = "random";
+        inst.n = n;
+        inst.source = 0;
+        inst.sink = n - 1;
+        for (int e = 0; e < m; ++e)
+            inst.add_edge(rng() % n, rng() % n, 1 + rng() % maxcap);
+        return inst;
+    }
+
+
+
+    /**
+      A width x height 4-connected grid, where each cell is linked to the source or the sink with some
+      probability, as in image segmentation.  The source and the sink are the last two vertices.
+      **/
+    static FlowInstance get_grid(int width, int height, long long maxcap, uint64 seed) {
+        mt19937_64 rng(seed);
+        FlowInstance inst;
+        inst.name = "grid";
+        inst.n = width * height + 2;
+        inst.source = width * height;
+        inst.sink = width * height + 1;
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) {
+                int v = y * width + x;
+                if (x + 1 < width) {
+                    inst.add_edge(v, v + 1, 1 + rng() % maxcap);
+                    inst.add_edge(v + 1, v, 1 + rng() % maxcap);
+                }
+                if (y + 1 < height) {
+                    inst.add_edge(v, v + width, 1 + rng() % maxcap);
+                    inst.add_edge(v + width, v, 1 + rng() % maxcap);
+                }
+                int r = rng() % 4;
+                if (r == 0)
+                    inst.add_edge(inst.source, v, 1 + rng() % (4 * maxcap));
+                else if (r == 1)
+                    inst.add_edge(v, inst.sink, 1 + rng() % (4 * maxcap));
+            }
+        }
+        return inst;
+    }
+
+
+
+    /**
+      Random bipartite MWIS-like network: n1 + n2 vertices, each V1 vertex linked to about degree V2 vertices
+      by infinite arcs, terminal capacities uniform in [1, maxcap] (use maxcap = 1 for unit capacities).
+      **/
+    static FlowInstance get_bipartite(int n1, int n2, int degree, long long maxcap, uint64 seed) {
+        mt19937_64 rng(seed);
+        FlowInstance inst;
+        inst.name = "bipartite";
+        inst.n = n1 + n2 + 2;
+        inst.source = 0;
+        inst.sink = 1;
+        long long inf = (long long)(n1 + n2) * maxcap + 1;
+        for (int i = 0; i < n1; ++i) {
+            inst.add_edge(0, 2 + i, 1 + rng() % maxcap);
+            for (int k = 0; k < degree; ++k)
+                inst.add_edge(2 + i, 2 + n1 + rng() % n2, inf);
+        }
+        for (int j = 0; j < n2; ++j)
+            inst.add_edge(2 + n1 + j, 1, 1 + rng() % maxcap);
+        return inst;
+    }
+
+
+
+    /**
+      MWIS min-cut network of an incompatibility graph, with node weights uniform in [1, maxcap].
+      **/
+    static FlowInstance get_incompat_network(const IncompatGraph& g, long long maxcap, uint64 seed) {
+        mt19937_64 rng(seed);
+        vector<long long> w1(g.n1), w2(g.n2);
+        for (auto& w : w1)
+            w = 1 + rng() % maxcap;
+        for (auto& w : w2)
+            w = 1 + rng() % maxcap;
+
+        vector<int> fid1, fid2;
+        PushRelabel collect(BipartiteMWIS::map_vertices(g, fid1, fid2));
+        BipartiteMWIS::add_network_edges(collect, w1, w2, g, fid1, fid2);
+
+        FlowInstance inst;
+        inst.name = "incompat";
+        inst.n = collect.n;
+        inst.source = 0;
+        inst.sink = 1;
+        inst.from = collect.edge_from;
+        inst.to = collect.edge_to;
+        inst.caps = collect.edge_cap;
+        return inst;
+    }
+
+
+
+    /**
+      MWIS network of the incompatibility graph of two random binary trees on nb_leaves leaves.
+      **/
+    static FlowInstance get_tree_pair(int nb_leaves, long long maxcap, uint64 seed) {
+        srand(seed);
+        Node* t1 = new Node();
+        Node* t2 = new Node();
+        TreeUtil::get_random_binary_tree(t1, nb_leaves);
+        TreeUtil::get_random_binary_tree(t2, nb_leaves);
+
+        TreePairInfo tpi(t1, t2);
+        FlowInstance inst = get_incompat_network(tpi.get_incompat_graph(), maxcap, seed);
+        inst.name = "treepair";
+
+        delete t1;
+        delete t2;
+        return inst;
+    }
+};
@@ -0,0 +1,256 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <iostream>
+#include <thread>
+
+#include "node.h"
+#include "rfdistance.h"
+
+using namespace std;
+
+
+/**
+  All-pairs Robinson-Foulds distances of a tree collection, HashRF style.  Every tree is hashed once with a shared
+  BipartitionHasher (one label table and leaf keys for the whole collection), and its splits are merged into a
+  global table that lists, for each distinct split, the trees that contain it.  Trees can be deleted as soon as
+  they are added.  Then RF(a, b) = |S(a)| + |S(b)| - 2 |S(a) & S(b)|, where the shared counts are accumulated
+  split by split.
+  A split found in more than half of the trees stores the trees that miss it instead: for a row a that has it,
+  every column gets +1 (kept as a per-row base) and the columns that miss it get -1.  On bootstrap and posterior
+  samples, where most splits are frequent, this turns the quadratic per-split cost into (trees with) x (trees
+  without).
+  The matrix is computed by blocks of rows, one block per thread, and each block sweeps the columns by tiles so
+  that its counters stay in cache.  Memory is the split table plus nbthreads x BLOCK_ROWS x nbtrees counters.
+  **/
+class HashRF {
+public:
+    static constexpr int BLOCK_ROWS = 32;
+    static constexpr int TILE_COLUMNS = 4096;
+
+    BipartitionHasher hasher;
+    bool rooted;
+
+    HashRF(bool rooted = false) : rooted(rooted) {}
+
+
+
+    /**
+      Adds the splits of tree as the next tree of the collection.  Returns false (and ignores the tree) if its
+      leaf set differs from the first tree.
+      **/
+    bool add_tree(Node* tree) {
+        vector<uint64> hashes;
+        uint64 total = 0;
+        int n = hasher.get_splits(tree, rooted, hashes, total);
+
+        if (tree_offsets.size() == 1) {
+            nbleaves = n;
+            leafset = total;
+        }
+        else if (n != nbleaves || total != leafset) {
+            return false;
+        }
+
+        int t = tree_offsets.size() - 1;
+        sort(hashes.begin(), hashes.end());
+        hashes.erase(unique(hashes.begin(), hashes.end()), hashes.end());
+        for (uint64 h : hashes) {
+            auto it = split_index.find(h);
+            int s;
+            if (it == split_index.end()) {
+                s = split_trees.size();
+                split_index[h] = s;
+                split_trees.push_back(vector<int>());
+            }
+            else {
+                s = it->second;
+            }
+            split_trees[s].push_back(t);
+            tree_splits.push_back(s);
+        }
+        tree_offsets.push_back(tree_splits.size());
+
+        return true;
+    }
+
+
+    int get_nb_trees() {
+        return tree_offsets.size() - 1;
+    }
+
+
+    int get_nb_distinct_splits() {
+        return split_trees.size();
+    }
+
+
+
+    /**
+      Computes the distance matrix with nbthreads threads, and calls write_row(a, row) for each tree a in order,
+      with row[b] = RF(a, b).
+      **/
+    template <class F>
+    void compute(int nbthreads, F write_row) {
+        build_tables();
+
+        int nbtrees = get_nb_trees();
+        nbthreads = max(1, nbthreads);
+        vector<vector<int>> counts(nbthreads, vector<int>((size_t)BLOCK_ROWS * nbtrees));
+        vector<vector<int>> bases(nbthreads, vector<int>(BLOCK_ROWS));
+        vector<int> row(nbtrees);
+
+        for (int start = 0; start < nbtrees; start += BLOCK_ROWS * nbthreads) {
+            vector<thread> threads;
+            for (int t = 0; t < nbthreads; ++t) {
+                int r0 = start + t * BLOCK_ROWS;
+                int r1 = min(nbtrees, r0 + BLOCK_ROWS);
+                if (r0 >= r1)
+                    break;
+                threads.push_back(thread([this, r0, r1, &counts, &bases, t] {
+                    compute_block(r0, r1, counts[t], bases[t]);
+                }));
+            }
+            for (thread& th : threads)
+                th.join();
+
+            for (int t = 0; t < nbthreads; ++t) {
+                int r0 = start + t * BLOCK_ROWS;
+                int r1 = min(nbtrees, r0 + BLOCK_ROWS);
+                for (int a = r0; a < r1; ++a) {
+                    const int* cnt = &counts[t][(size_t)(a - r0) * nbtrees];
+                    int base = bases[t][a - r0];
+                    int sa = tree_offsets[a + 1] - tree_offsets[a];
+                    for (int b = 0; b < nbtrees; ++b)
+                        row[b] = sa + (tree_offsets[b + 1] - tree_offsets[b]) - 2 * (cnt[b] + base);
+                    write_row(a, row);
+                }
+            }
+        }
+    }
+
+
+
+    /**
+      Writes the matrix as text (one row per line, space separated) or in binary: the 8 bytes magic "TURFM1",
+      the number of trees as a uint64, then the rows as uint32.
+      **/
+    void write_matrix(ostream& out, bool binary, int nbthreads) {
+        uint64 nbtrees = get_nb_trees();
+        if (binary) {
+            char magic[8] = "TURFM1";
+            out.write(magic, 8);
+            out.write((const char*)&nbtrees, sizeof(nbtrees));
+        }
+
+        vector<uint32_t> buf;
+        string line;
+        compute(nbthreads, [&](int a, const vector<int>& row) {
+            if (binary) {
+                buf.assign(row.begin(), row.end());
+                out.write((const char*)buf.data(), buf.size() * sizeof(uint32_t));
+            }
+            else {
+                line.clear();
+                for (size_t b = 0; b < row.size(); ++b) {
+                    if (b > 0)
+                        line += ' ';
+                    line += to_string(row[b]);
+                }
+                line += '\n';
+                out << line;
+            }
+        });
+        out.flush();
+    }
+
+
+
+private:
+    int nbleaves = -1;
+    uint64 leafset = 0;
+
+    unordered_map<uint64, int> split_index;
+    vector<vector<int>> split_trees;
+
+    //splits of each tree, in CSR form
+    vector<size_t> tree_offsets = { 0 };
+    vector<int> tree_splits;
+
+    //trees of each split (or the trees that miss it, if split_complemented), in CSR form
+    vector<size_t> split_offsets;
+    vector<int> split_members;
+    vector<char> split_complemented;
+
+
+
+    void build_tables() {
+        int nbtrees = get_nb_trees();
+        split_offsets.assign(1, 0);
+        split_members.clear();
+        split_complemented.assign(split_trees.size(), false);
+
+        for (size_t s = 0; s < split_trees.size(); ++s) {
+            vector<int>& trees = split_trees[s];
+            if (2 * trees.size() > (size_t)nbtrees) {
+                split_complemented[s] = true;
+                size_t k = 0;
+                for (int t = 0; t < nbtrees; ++t) {
+                    if (k < trees.size() && trees[k] == t)
+                        k++;
+                    else
+                        split_members.push_back(t);
+                }
+            }
+            else {
+                split_members.insert(split_members.end(), trees.begin(), trees.end());
+            }
+            split_offsets.push_back(split_members.size());
+        }
+    }
+
+
+
+    /**
+      Shared split counts of rows [r0, r1) against all the trees, in cnt (row major, minus base for each row).
+      Each (row, split) pair keeps a cursor in the member list of the split, which only moves forward as the
+      column tiles are swept.
+      **/
+    void compute_block(int r0, int r1, vector<int>& cnt, vector<int>& base) {
+        int nbtrees = get_nb_trees();
+        fill(cnt.begin(), cnt.begin() + (size_t)(r1 - r0) * nbtrees, 0);
+        fill(base.begin(), base.end(), 0);
+
+        vector<size_t> cursors(tree_splits.begin() + tree_offsets[r0], tree_splits.begin() + tree_offsets[r1]);
+        for (size_t k = 0; k < cursors.size(); ++k)
+            cursors[k] = split_offsets[cursors[k]];
+
+        for (int a = r0; a < r1; ++a) {
+            for (size_t k = tree_offsets[a]; k < tree_offsets[a + 1]; ++k) {
+                if (split_complemented[tree_splits[k]])
+                    base[a - r0]++;
+            }
+        }
+
+        for (int c1 = TILE_COLUMNS; c1 < nbtrees + TILE_COLUMNS; c1 += TILE_COLUMNS) {
+            size_t k = 0;
+            for (int a = r0; a < r1; ++a) {
+                int* row = &cnt[(size_t)(a - r0) * nbtrees];
+                for (size_t i = tree_offsets[a]; i < tree_offsets[a + 1]; ++i, ++k) {
+                    int s = tree_splits[i];
+                    size_t end = split_offsets[s + 1];
+                    size_t cur = cursors[k];
+                    int delta = (split_complemented[s] ? -1 : 1);
+                    while (cur < end && split_members[cur] < c1) {
+                        row[split_members[cur]] += delta;
+                        cur++;
+                    }
+                    cursors[k] = cur;
+                }
+            }
+        }
+    }
+};
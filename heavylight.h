@@ -0,0 +1,237 @@
+#pragma once
+
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <limits>
+
+#include "node.h"
+
+using namespace std;
+
+
+/**
+  Heavy-light decomposition of a fixed tree, with a value per node, for aggregates (sum, min, max) over the
+  paths between two nodes.  Each node continues the heavy path of its child with the largest subtree, so a path
+  crosses O(log n) heavy paths.  Nodes are numbered by a DFS that visits heavy children first (the root is 0),
+  which makes every heavy path a range of ids, and the values are kept in a segment tree over the ids.  Queries
+  and point updates take O(log^2 n) and O(log n).
+  A value usually describes the edge above its node (e.g. its branch length or its support), in which case
+  path queries should exclude the LCA of the two ends.
+  **/
+class HeavyLightIndex {
+public:
+    struct PathAggregate {
+        double sum = 0.0;
+        double min = numeric_limits<double>::infinity();
+        double max = -numeric_limits<double>::infinity();
+        int nb_nodes = 0;           //number of values aggregated
+    };
+
+
+
+    HeavyLightIndex(Node* root) {
+        vector<Node*> postorder = root->get_postordered_nodes();
+        int n = postorder.size();
+        unordered_map<Node*, int> sizes;
+        for (Node* v : postorder) {
+            int s = 1;
+            for (int i = 0; i < v->get_nb_children(); ++i)
+                s += sizes[v->get_child(i)];
+            sizes[v] = s;
+        }
+
+        nodes.reserve(n);
+        parents.reserve(n);
+        depths.reserve(n);
+        heads.reserve(n);
+
+        //node, parent id, head id; the heavy child is pushed last so that it is visited right after its parent
+        vector<pair<Node*, pair<int, int>>> stack;
+        stack.push_back(make_pair(root, make_pair(-1, 0)));
+        while (!stack.empty()) {
+            Node* v = stack.back().first;
+            int parent = stack.back().second.first;
+            int head = stack.back().second.second;
+            stack.pop_back();
+
+            int id = nodes.size();
+            ids[v] = id;
+            nodes.push_back(v);
+            parents.push_back(parent);
+            depths.push_back(parent == -1 ? 0 : depths[parent] + 1);
+            heads.push_back(head == -1 ? id : head);
+
+            Node* heavy = nullptr;
+            for (int i = 0; i < v->get_nb_children(); ++i) {
+                Node* c = v->get_child(i);
+                if (!heavy || sizes[c] > sizes[heavy])
+                    heavy = c;
+            }
+            for (int i = 0; i < v->get_nb_children(); ++i) {
+                Node* c = v->get_child(i);
+                if (c != heavy)
+                    stack.push_back(make_pair(c, make_pair(id, -1)));
+            }
+            if (heavy)
+                stack.push_back(make_pair(heavy, make_pair(id, heads[id])));
+        }
+
+        size = 1;
+        while (size < n)
+            size *= 2;
+        sums.assign(2 * size, 0.0);
+        mins.assign(2 * size, numeric_limits<double>::infinity());
+        maxs.assign(2 * size, -numeric_limits<double>::infinity());
+        for (int i = 0; i < n; ++i)
+            mins[size + i] = maxs[size + i] = 0.0;
+        for (int i = size - 1; i >= 1; --i)
+            pull(i);
+    }
+
+
+
+    int get_nb_nodes() const {
+        return nodes.size();
+    }
+
+    Node* get_node(int id) const {
+        return nodes[id];
+    }
+
+    int get_parent(int id) const {
+        return parents[id];
+    }
+
+    int get_depth(int id) const {
+        return depths[id];
+    }
+
+
+    /**
+      Id of the node, or -1 if it is not in the indexed tree.
+      **/
+    int get_id(Node* v) const {
+        auto it = ids.find(v);
+        return (it == ids.end() ? -1 : it->second);
+    }
+
+
+
+    double get_value(int id) const {
+        return sums[size + id];
+    }
+
+
+    /**
+      Changes the value of one node, in O(log n).
+      **/
+    void set_value(int id, double value) {
+        int i = size + id;
+        sums[i] = mins[i] = maxs[i] = value;
+        for (i >>= 1; i >= 1; i >>= 1)
+            pull(i);
+    }
+
+
+    /**
+      Sets the value of every node to f(node), in O(n).
+      **/
+    template <class F>
+    void set_values(F f) {
+        for (size_t id = 0; id < nodes.size(); ++id) {
+            double value = f(nodes[id]);
+            sums[size + id] = mins[size + id] = maxs[size + id] = value;
+        }
+        for (int i = size - 1; i >= 1; --i)
+            pull(i);
+    }
+
+
+
+    int get_lca(int a, int b) const {
+        while (heads[a] != heads[b]) {
+            if (depths[heads[a]] < depths[heads[b]])
+                swap(a, b);
+            a = parents[heads[a]];
+        }
+        return (depths[a] < depths[b] ? a : b);
+    }
+
+
+
+    /**
+      Aggregates the values of the nodes on the path between a and b, both included, without their LCA if
+      exclude_lca is set (for values on edges).
+      **/
+    PathAggregate query_path(int a, int b, bool exclude_lca = false) const {
+        PathAggregate result;
+        while (heads[a] != heads[b]) {
+            if (depths[heads[a]] < depths[heads[b]])
+                swap(a, b);
+            query_range(heads[a], a + 1, result);
+            a = parents[heads[a]];
+        }
+        if (a > b)
+            swap(a, b);
+        //a is the LCA, and is the smallest id of the range since ids follow the heavy paths downwards
+        query_range(a + (exclude_lca ? 1 : 0), b + 1, result);
+        return result;
+    }
+
+
+    double get_path_sum(int a, int b, bool exclude_lca = false) const {
+        return query_path(a, b, exclude_lca).sum;
+    }
+
+    double get_path_min(int a, int b, bool exclude_lca = false) const {
+        return query_path(a, b, exclude_lca).min;
+    }
+
+    double get_path_max(int a, int b, bool exclude_lca = false) const {
+        return query_path(a, b, exclude_lca).max;
+    }
+
+
+
+private:
+    vector<Node*> nodes;
+    unordered_map<Node*, int> ids;
+    vector<int> parents, depths, heads;
+
+    int size;
+    vector<double> sums, mins, maxs;
+
+
+    void pull(int i) {
+        sums[i] = sums[2 * i] + sums[2 * i + 1];
+        mins[i] = min(mins[2 * i], mins[2 * i + 1]);
+        maxs[i] = max(maxs[2 * i], maxs[2 * i + 1]);
+    }
+
+
+    /**
+      Adds the values of the ids [l, r) to result.
+      **/
+    void query_range(int l, int r, PathAggregate& result) const {
+        if (l >= r)
+            return;
+        result.nb_nodes += r - l;
+        for (l += size, r += size; l < r; l >>= 1, r >>= 1) {
+            if (l & 1) {
+                add(l, result);
+                l++;
+            }
+            if (r & 1) {
+                --r;
+                add(r, result);
+            }
+        }
+    }
+
+    void add(int i, PathAggregate& result) const {
+        result.sum += sums[i];
+        result.min = min(result.min, mins[i]);
+        result.max = max(result.max, maxs[i]);
+    }
+};
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <unordered_set>
+#include <algorithm>
+
+#include "node.h"
+#include "lcaindex.h"
+
+using namespace std;
+
+
+/**
+  Restrictions of a fixed tree to subsets of its leaves.  The subtree induced by k leaves (their virtual tree)
+  has the leaves and the LCAs of the leaves that are consecutive in preorder, and each of its edges stands for
+  a path of the tree, whose length is the difference of the distances to the root.  With the preorder ids and
+  the constant time LCA queries of an LCAIndex, a restriction costs O(k log k), whatever the size of the tree.
+  Nodes keep their labels (e.g. supports for internal nodes).
+  **/
+class InducedSubtreeBuilder {
+public:
+    const LCAIndex& index;
+
+    /**
+      O(n) for the distances to the root of the indexed tree.
+      **/
+    InducedSubtreeBuilder(const LCAIndex& index) : index(index) {
+        distances.assign(index.get_nb_nodes(), 0.0);
+        for (int id = 1; id < index.get_nb_nodes(); ++id)
+            distances[id] = distances[index.get_parent(id)] + index.get_node(id)->branch_length;
+    }
+
+
+
+    /**
+      Subtree induced by the leaves with these labels.  Unknown labels and duplicates are ignored.  Returns nullptr
+      if no label is found.  User has to delete returned value.
+      **/
+    Node* build(const vector<string>& labels) const {
+        vector<int> ids;
+        for (const string& label : labels) {
+            int id = index.get_leaf_id(label);
+            if (id != -1)
+                ids.push_back(id);
+        }
+        return build_from_ids(ids);
+    }
+
+
+
+    /**
+      Subtree induced by the nodes with these ids (usually leaves).  The root of the result is the LCA of the
+      nodes, with a zero branch length.  User has to delete returned value.
+      **/
+    Node* build_from_ids(vector<int> ids) const {
+        if (ids.empty())
+            return nullptr;
+
+        //ids are preorder ranks, so the LCAs of consecutive nodes are all the branching nodes
+        sort(ids.begin(), ids.end());
+        ids.erase(unique(ids.begin(), ids.end()), ids.end());
+        size_t k = ids.size();
+        for (size_t i = 0; i + 1 < k; ++i)
+            ids.push_back(index.get_lca(ids[i], ids[i + 1]));
+        sort(ids.begin(), ids.end());
+        ids.erase(unique(ids.begin(), ids.end()), ids.end());
+
+        //in preorder, the parent of a node is the last node on the stack that is one of its ancestors
+        vector<pair<int, Node*>> stack;
+        Node* root = nullptr;
+        for (int id : ids) {
+            while (!stack.empty() && index.get_lca(stack.back().first, id) != stack.back().first)
+                stack.pop_back();
+
+            Node* v;
+            if (stack.empty()) {
+                v = new Node();
+                root = v;
+            }
+            else {
+                v = stack.back().second->add_child();
+                v->branch_length = distances[id] - distances[stack.back().first];
+            }
+            v->label = index.get_node(id)->label;
+            stack.push_back(make_pair(id, v));
+        }
+
+        return root;
+    }
+
+
+
+    /**
+      Replaces t1 and t2 by their restrictions to their common leaves, unless they already have the same leaf
+      set, so that they can be compared with TreePairInfo.  The original trees are deleted.  Returns the number
+      of common leaves.  If there is none, the trees are left unchanged.
+      **/
+    static int restrict_to_common_leaves(Node*& t1, Node*& t2) {
+        unordered_set<string> labels2;
+        for (Node* v : *t2) {
+            if (v->is_leaf())
+                labels2.insert(v->label);
+        }
+
+        vector<string> common;
+        int nbleaves1 = 0;
+        for (Node* v : *t1) {
+            if (v->is_leaf()) {
+                nbleaves1++;
+                if (labels2.count(v->label))
+                    common.push_back(v->label);
+            }
+        }
+
+        if (common.empty() || (common.size() == labels2.size() && (int)common.size() == nbleaves1))
+            return common.size();
+
+        for (Node** t : { &t1, &t2 }) {
+            Node* restricted;
+            {
+                LCAIndex tree_index(*t);
+                InducedSubtreeBuilder builder(tree_index);
+                restricted = builder.build(common);
+            }
+            delete *t;
+            *t = restricted;
+        }
+        return common.size();
+    }
+
+
+
+private:
+    vector<double> distances;     //to the root, by node id
+};
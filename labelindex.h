@@ -0,0 +1,268 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <algorithm>
+
+#include "node.h"
+
+using namespace std;
+
+
+/**
+  Index of the nodes of a tree by label: open addressing hash table with linear probing, kept at most half full,
+  with the hash of each label stored in its slot so that probes rarely compare strings.  Built in one traversal,
+  and updated by add, remove and relabel when the tree is edited, with backward shift deletion so that no
+  tombstones accumulate.  Lookups, updates and duplicate checks take O(1) expected time.
+  A label can be held by several nodes: its slot keeps the first one added, and the others in a side list.
+  **/
+class LabelIndex {
+public:
+    /**
+      Indexes the leaves of the tree, or all its nodes with a non-empty label if leaves_only is false.
+      **/
+    LabelIndex(Node* root, bool leaves_only = true) {
+        slots.assign(16, Slot());
+        if (root) {
+            for (Node* v : *root) {
+                if (v->is_leaf() || (!leaves_only && v->label != ""))
+                    add(v);
+            }
+        }
+    }
+
+
+
+    /**
+      Number of indexed nodes.
+      **/
+    int get_nb_nodes() const {
+        return nbnodes;
+    }
+
+
+    /**
+      First node added with this label, or nullptr.
+      **/
+    Node* find(const string& label) const {
+        int s = find_slot(label, hash<string>()(label));
+        return (s == -1 ? nullptr : slots[s].node);
+    }
+
+
+    /**
+      Looks up each label, and fills nodes with the results of find.
+      **/
+    void find(const vector<string>& labels, vector<Node*>& nodes) const {
+        nodes.resize(labels.size());
+        for (size_t i = 0; i < labels.size(); ++i)
+            nodes[i] = find(labels[i]);
+    }
+
+
+    /**
+      All the nodes with this label.
+      **/
+    vector<Node*> find_all(const string& label) const {
+        vector<Node*> nodes;
+        int s = find_slot(label, hash<string>()(label));
+        if (s != -1) {
+            nodes.push_back(slots[s].node);
+            if (slots[s].duplicates != -1)
+                nodes.insert(nodes.end(), duplicate_lists[slots[s].duplicates].begin(), duplicate_lists[slots[s].duplicates].end());
+        }
+        return nodes;
+    }
+
+
+    /**
+      Number of indexed nodes with this label.
+      **/
+    int count(const string& label) const {
+        int s = find_slot(label, hash<string>()(label));
+        if (s == -1)
+            return 0;
+        return 1 + (slots[s].duplicates == -1 ? 0 : duplicate_lists[slots[s].duplicates].size());
+    }
+
+
+    bool has_duplicates() const {
+        return nbduplicated > 0;
+    }
+
+
+    /**
+      Labels held by more than one node, in no particular order.
+      **/
+    vector<string> get_duplicated_labels() const {
+        vector<string> labels;
+        for (const Slot& slot : slots) {
+            if (slot.node && slot.duplicates != -1)
+                labels.push_back(slot.label);
+        }
+        return labels;
+    }
+
+
+
+    /**
+      Indexes v under its current label.
+      **/
+    void add(Node* v) {
+        if (2 * (nbslots_used + 1) > slots.size())
+            grow();
+
+        size_t h = hash<string>()(v->label);
+        int s = find_slot(v->label, h);
+        nbnodes++;
+        if (s == -1) {
+            size_t i = h & (slots.size() - 1);
+            while (slots[i].node)
+                i = (i + 1) & (slots.size() - 1);
+            slots[i].hash = h;
+            slots[i].label = v->label;
+            slots[i].node = v;
+            slots[i].duplicates = -1;
+            nbslots_used++;
+            return;
+        }
+
+        Slot& slot = slots[s];
+        if (slot.duplicates == -1) {
+            slot.duplicates = get_free_list();
+            nbduplicated++;
+        }
+        duplicate_lists[slot.duplicates].push_back(v);
+    }
+
+
+
+    /**
+      Removes v, which must be indexed under its current label (use relabel to change labels).  Returns false
+      if it is not.
+      **/
+    bool remove(Node* v) {
+        int s = find_slot(v->label, hash<string>()(v->label));
+        if (s == -1)
+            return false;
+
+        Slot& slot = slots[s];
+        if (slot.node != v) {
+            if (slot.duplicates == -1)
+                return false;
+            vector<Node*>& list = duplicate_lists[slot.duplicates];
+            auto it = std::find(list.begin(), list.end(), v);
+            if (it == list.end())
+                return false;
+            list.erase(it);
+        }
+        else if (slot.duplicates != -1) {
+            vector<Node*>& list = duplicate_lists[slot.duplicates];
+            slot.node = list.front();
+            list.erase(list.begin());
+        }
+        else {
+            erase_slot(s);
+            nbnodes--;
+            return true;
+        }
+
+        if (duplicate_lists[slot.duplicates].empty()) {
+            free_lists.push_back(slot.duplicates);
+            slot.duplicates = -1;
+            nbduplicated--;
+        }
+        nbnodes--;
+        return true;
+    }
+
+
+
+    /**
+      Changes the label of v, indexed or not, and indexes it under the new label.
+      **/
+    void relabel(Node* v, const string& label) {
+        remove(v);
+        v->label = label;
+        add(v);
+    }
+
+
+
+private:
+    struct Slot {
+        size_t hash = 0;
+        string label;
+        Node* node = nullptr;       //nullptr for an empty slot
+        int duplicates = -1;        //index in duplicate_lists of the other nodes with this label, if any
+    };
+
+    vector<Slot> slots;             //size is a power of 2
+    size_t nbslots_used = 0;
+    int nbnodes = 0;
+    int nbduplicated = 0;           //labels with several nodes
+    vector<vector<Node*>> duplicate_lists;
+    vector<int> free_lists;
+
+
+
+    int find_slot(const string& label, size_t h) const {
+        size_t mask = slots.size() - 1;
+        for (size_t i = h & mask; slots[i].node; i = (i + 1) & mask) {
+            if (slots[i].hash == h && slots[i].label == label)
+                return i;
+        }
+        return -1;
+    }
+
+
+    int get_free_list() {
+        if (!free_lists.empty()) {
+            int l = free_lists.back();
+            free_lists.pop_back();
+            return l;
+        }
+        duplicate_lists.push_back(vector<Node*>());
+        return duplicate_lists.size() - 1;
+    }
+
+
+    /**
+      Empties slot s, and moves back the following slots of its probe run that would otherwise become
+      unreachable.
+      **/
+    void erase_slot(size_t s) {
+        size_t mask = slots.size() - 1;
+        slots[s] = Slot();
+        nbslots_used--;
+
+        size_t i = s;
+        for (size_t j = (s + 1) & mask; slots[j].node; j = (j + 1) & mask) {
+            size_t home = slots[j].hash & mask;
+            //slot j can move to i if its home is not in (i, j], cyclically
+            bool stays = (i <= j ? (home > i && home <= j) : (home > i || home <= j));
+            if (!stays) {
+                slots[i] = move(slots[j]);
+                slots[j] = Slot();
+                i = j;
+            }
+        }
+    }
+
+
+    void grow() {
+        vector<Slot> old;
+        old.swap(slots);
+        slots.assign(2 * old.size(), Slot());
+        size_t mask = slots.size() - 1;
+        for (Slot& slot : old) {
+            if (!slot.node)
+                continue;
+            size_t i = slot.hash & mask;
+            while (slots[i].node)
+                i = (i + 1) & mask;
+            slots[i] = move(slot);
+        }
+    }
+};
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+
+#include "node.h"
+
+using namespace std;
+
+
+/**
+  Constant time lowest common ancestor queries on a fixed tree: Euler tour of the nodes, and a sparse table of
+  range minimum depths over it.  O(n log n) preprocessing and memory.  Nodes are numbered in preorder (the root is
+  0) and leaves can be found by label.  Queries do not modify the index, so it can be shared by threads.
+  **/
+class LCAIndex {
+public:
+    LCAIndex(Node* root) {
+        vector<pair<Node*, int>> stack;     //node, index of the next child to visit
+        stack.push_back(make_pair(root, 0));
+        add_node(root, -1);
+        euler.push_back(0);
+
+        while (!stack.empty()) {
+            Node* v = stack.back().first;
+            int next = stack.back().second;
+            if (next < v->get_nb_children()) {
+                stack.back().second++;
+                Node* c = v->get_child(next);
+                add_node(c, node_ids[v]);
+                euler.push_back(node_ids[c]);
+                stack.push_back(make_pair(c, 0));
+            }
+            else {
+                stack.pop_back();
+                if (!stack.empty())
+                    euler.push_back(node_ids[stack.back().first]);
+            }
+        }
+
+        first_occurrence.assign(nodes.size(), -1);
+        for (size_t i = 0; i < euler.size(); ++i) {
+            if (first_occurrence[euler[i]] == -1)
+                first_occurrence[euler[i]] = i;
+        }
+
+        int m = euler.size();
+        log2s.assign(m + 1, 0);
+        for (int i = 2; i <= m; ++i)
+            log2s[i] = log2s[i / 2] + 1;
+        sparse.push_back(euler);
+        for (int k = 1; (1 << k) <= m; ++k) {
+            vector<int>& prev = sparse[k - 1];
+            vector<int> level(m - (1 << k) + 1);
+            for (size_t i = 0; i < level.size(); ++i)
+                level[i] = shallowest(prev[i], prev[i + (1 << (k - 1))]);
+            sparse.push_back(level);
+        }
+    }
+
+
+    int get_nb_nodes() const {
+        return nodes.size();
+    }
+
+    Node* get_node(int id) const {
+        return nodes[id];
+    }
+
+    int get_depth(int id) const {
+        return depths[id];
+    }
+
+    int get_parent(int id) const {
+        return parents[id];
+    }
+
+
+    /**
+      Id of the node, or -1 if it is not in the indexed tree.
+      **/
+    int get_id(Node* v) const {
+        auto it = node_ids.find(v);
+        return (it == node_ids.end() ? -1 : it->second);
+    }
+
+
+    /**
+      Id of the leaf with this label, or -1 if there is none.
+      **/
+    int get_leaf_id(const string& label) const {
+        auto it = leaf_ids.find(label);
+        return (it == leaf_ids.end() ? -1 : it->second);
+    }
+
+
+    int get_lca(int a, int b) const {
+        int l = first_occurrence[a], r = first_occurrence[b];
+        if (l > r)
+            swap(l, r);
+        int k = log2s[r - l + 1];
+        return shallowest(sparse[k][l], sparse[k][r - (1 << k) + 1]);
+    }
+
+
+private:
+    vector<Node*> nodes;
+    vector<int> depths;
+    vector<int> parents;
+    unordered_map<Node*, int> node_ids;
+    unordered_map<string, int> leaf_ids;
+
+    vector<int> euler;
+    vector<int> first_occurrence;
+    vector<int> log2s;
+    vector<vector<int>> sparse;
+
+
+    void add_node(Node* v, int parent) {
+        int id = nodes.size();
+        nodes.push_back(v);
+        parents.push_back(parent);
+        depths.push_back(parent == -1 ? 0 : depths[parent] + 1);
+        node_ids[v] = id;
+        if (v->is_leaf())
+            leaf_ids[v->label] = id;
+    }
+
+    int shallowest(int a, int b) const {
+        return (depths[a] <= depths[b] ? a : b);
+    }
+};
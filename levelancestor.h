@@ -0,0 +1,135 @@
+#pragma once
+
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+
+#include "node.h"
+
+using namespace std;
+
+
+/**
+  Ancestor queries on a fixed tree with jump pointers: up[k][v] is the 2^k-th ancestor of v (or the root), so
+  the ancestor at a given depth, or the highest one at a given distance from the root, is found in O(log n)
+  jumps.  O(n log n) preprocessing and memory.  Nodes are numbered in preorder (the root is 0).  Distance
+  queries assume non-negative branch lengths, so that distances to the root decrease towards the root.
+  **/
+class LevelAncestorIndex {
+public:
+    LevelAncestorIndex(Node* root) {
+        vector<pair<Node*, int>> stack;     //node, parent id
+        stack.push_back(make_pair(root, -1));
+        while (!stack.empty()) {
+            Node* v = stack.back().first;
+            int parent = stack.back().second;
+            stack.pop_back();
+
+            int id = nodes.size();
+            ids[v] = id;
+            nodes.push_back(v);
+            parents.push_back(parent);
+            depths.push_back(parent == -1 ? 0 : depths[parent] + 1);
+            distances.push_back(parent == -1 ? 0.0 : distances[parent] + v->branch_length);
+
+            for (int i = v->get_nb_children() - 1; i >= 0; --i)
+                stack.push_back(make_pair(v->get_child(i), id));
+        }
+
+        int n = nodes.size();
+        int maxdepth = *max_element(depths.begin(), depths.end());
+        up.push_back(vector<int>(n));
+        for (int v = 0; v < n; ++v)
+            up[0][v] = (parents[v] == -1 ? v : parents[v]);
+        for (int k = 1; (1 << k) <= maxdepth; ++k) {
+            vector<int>& prev = up[k - 1];
+            vector<int> level(n);
+            for (int v = 0; v < n; ++v)
+                level[v] = prev[prev[v]];
+            up.push_back(level);
+        }
+    }
+
+
+    int get_nb_nodes() const {
+        return nodes.size();
+    }
+
+    Node* get_node(int id) const {
+        return nodes[id];
+    }
+
+    int get_parent(int id) const {
+        return parents[id];
+    }
+
+    int get_depth(int id) const {
+        return depths[id];
+    }
+
+    /**
+      Sum of the branch lengths from the root to the node.
+      **/
+    double get_distance(int id) const {
+        return distances[id];
+    }
+
+
+    /**
+      Id of the node, or -1 if it is not in the indexed tree.
+      **/
+    int get_id(Node* v) const {
+        auto it = ids.find(v);
+        return (it == ids.end() ? -1 : it->second);
+    }
+
+
+
+    /**
+      Ancestor k edges above the node (the node itself for k = 0), or -1 if the node is less than k deep.
+      **/
+    int get_kth_ancestor(int id, int k) const {
+        if (k < 0 || k > depths[id])
+            return -1;
+        for (int b = 0; k > 0; ++b, k >>= 1) {
+            if (k & 1)
+                id = up[b][id];
+        }
+        return id;
+    }
+
+
+    /**
+      Ancestor of the node at this depth, or -1 if the node is not that deep.
+      **/
+    int get_level_ancestor(int id, int depth) const {
+        return get_kth_ancestor(id, depths[id] - depth);
+    }
+
+
+
+    /**
+      Highest ancestor of the node (possibly itself) whose distance to the root is at least x, or -1 if the
+      node is closer than x to the root.  When the tree is cut at distance x from the root, this is the root of
+      the part below the cut that contains the node.
+      **/
+    int get_highest_ancestor_at_distance(int id, double x) const {
+        if (distances[id] < x)
+            return -1;
+        for (int k = up.size() - 1; k >= 0; --k) {
+            int a = up[k][id];
+            if (distances[a] >= x)
+                id = a;
+        }
+        return id;
+    }
+
+
+
+private:
+    vector<Node*> nodes;
+    unordered_map<Node*, int> ids;
+    vector<int> parents, depths;
+    vector<double> distances;
+    vector<vector<int>> up;
+};
@@ -1,347 +1,1600 @@
-#include <set>
-#include <iostream>
-#include <time.h>
-#include <map>
-#include <string>
-#include <fstream>
-
-
-#include "node.h"
-#include "newicklex.h"
-#include "treeutil.h"
-#include "ewah/ewah.h"
-
-#include "BipartiteMWIS.h"
-
-using namespace std;
-
-
-typedef ewah::EWAHBoolArray<uint32_t> bitmap;
-
-
-
-
-
-struct NodeInfo {
-	int id;
-	bitmap clade;
-	bitmap clade_comp;	//complement of the clade
-};
-
-
-struct TreePairInfo {
-	Node* t1;
-	Node* t2;
-	map<string, int> label_to_leafid;
-	map<Node*, NodeInfo> infos;
-
-
-	bitmap _all_ones;	//temp variable
-
-	int cpt_id, leaf_id;
-	int nb_leaves;
-
-	TreePairInfo(Node* t1, Node* t2) : t1(t1), t2(t2) {
-		cpt_id = 1;
-		leaf_id = 1;
-
-		
-		//count leaves, losing time...
-		nb_leaves = 0;
-		for (auto it = t1->begin(); it != t1->end(); ++it) {
-			if ((*it)->is_leaf()) {
-				nb_leaves++;
-				_all_ones.set(nb_leaves);
-			}
-		}
-		
-
-		preprocess_tree_rec(t1, true);
-		
-		preprocess_tree_rec(t2, false);
-	}
-
-	void preprocess_tree_rec(Node* v, bool is_tree1) {
-		
-		infos[v].id = cpt_id;
-		cpt_id++;
-		
-		if (v->is_leaf()) {
-			
-			if (is_tree1) {
-				infos[v].id = leaf_id;
-				
-				infos[v].clade.set(leaf_id);
-				infos[v].clade_comp = _all_ones.logicalandnot(infos[v].clade);
-
-				label_to_leafid[v->label] = leaf_id;
-				leaf_id++;
-			}
-			else {
-				infos[v].id = label_to_leafid[v->label];
-				infos[v].clade.set(infos[v].id);
-				infos[v].clade_comp = _all_ones.logicalandnot(infos[v].clade);
-			}
-			
-		}
-		else {
-			for (int i = 0; i < v->get_nb_children(); ++i) {
-				preprocess_tree_rec(v->get_child(i), is_tree1);
-
-				if (i == 0)
-					infos[v].clade = infos[v->get_child(i)].clade;
-				else 
-					infos[v].clade = infos[v].clade | infos[v->get_child(i)].clade;
-			}
-			infos[v].clade_comp = _all_ones.logicalandnot(infos[v].clade);
-		}
-	}
-
-
-
-	map<Node*, vector<Node*>> get_imcompats() {
-
-		map<Node*, vector<Node*>> ret;
-		int cpt = 0;
-		for (auto it1 = t1->begin(); it1 != t1->end(); ++it1) {
-
-			cpt++;
-
-			if (cpt % 100 == 0)
-				cout << "cpt=" << cpt << endl;
-			Node* v1 = (*it1);
-
-			
-			bitmap A = infos[v1].clade;
-			bitmap B = infos[v1].clade_comp;
-
-			for (auto it2 = t2->begin(); it2 != t2->end(); ++it2) {
-
-				Node* v2 = (*it2);
-
-				bitmap C = infos[v2].clade;
-				bitmap D = infos[v2].clade_comp;
-
-				
-				
-				//incompatible iff nb intersections if three or more
-				int nbinter = 0;
-				if (A.intersects(C))
-					++nbinter;
-				if (A.intersects(D))
-					++nbinter;
-				if (B.intersects(C))
-					++nbinter;
-				if (B.intersects(D))
-					++nbinter;
-
-				if (nbinter != 2 && nbinter != 3) {
-					ret[v1].push_back(v2);
-				}
-
-
-				//cout << "Comparing v=" << A << "|" << B << "  w=" << C << "|" << D << "      nbi=" << nbinter << endl;
-
-			}
-		}
-
-		return ret;
-	}
-
-	
-};
-
-
-
-
-
-
-
-
-
-
-//that function is chatGPT
-map<string, string> parseArguments(int argc, char* argv[]) {
-	map<string, string> args;
-
-	for (int i = 1; i < argc; ++i) {
-		string arg = argv[i];
-
-		// Check if argument starts with "--" or "-"
-		if (arg.rfind("--", 0) == 0 || arg.rfind("-", 0) == 0) {
-			// Remove the leading dashes
-			string argName = arg.substr(arg.find_first_not_of('-'));
-
-			// Check if the next argument exists and doesn't start with "-"
-			if (i + 1 < argc && argv[i + 1][0] != '-') {
-				args[argName] = argv[i + 1];
-				++i;  // Skip the next argument, as it's the value for the current argument
-			}
-			else {
-				args[argName] = "";  // For flags without a value
-			}
-		}
-	}
-
-	return args;
-}
-
-
-
-
-void exec_all_reroots(map<string, string>& args) {
-	string infilename = "";
-	if (args.count("i"))
-		infilename = args["i"];
-	else {
-		cout << "Please specify an input filename with -i [filename]" << endl;
-		return;
-	}
-
-	string outfilename = "";
-	if (args.count("o"))
-		outfilename = args["o"];
-
-	string incontent = Util::GetFileContent(infilename);
-	
-
-	if (incontent == "") {
-		cout << "Could not find newick string.  Make sure the specified file exists and is non-empty." << endl;
-		return;
-	}
-
-	Node* root = NewickLex::ParseNewickString(incontent);
-	vector<Node*> nodes = root->get_postordered_nodes();
-
-	string outstr = "";
-	
-	for (Node* v : nodes) {
-
-		if (v->is_root())
-			continue;
-
-		Node* w = TreeUtil::subdivide_parent_edge(v);
-		TreeUtil::reroot_on_node(w);
-
-		string newick = NewickLex::ToNewickString(w, true, true);
-		outstr += newick + "\n";
-
-		TreeUtil::reroot_on_node(root);
-		TreeUtil::contract_parent_edge(w);
-	}
-
-	if (outfilename == "")
-		cout << outstr;
-	else {
-		Util::WriteFileContent(outfilename, outstr);
-	}
-
-
-}
-
-
-
-
-
-int main(int argc, char** argv) {
-
-	BipartiteMWIS bwis;
-
-	map<string, string> args = parseArguments(argc, argv);
-
-	/*
-	//just some tests
-	args["m"] = "rnd";
-	args["n"] = "10000";
-	//args["o"] = "C:\\Users\\Manuel\\Desktop\\tmp\\trees.txt";
-
-	args["m"] = "all_reroots";
-	//args["i"] = "C:\\Users\\Manuel\\Desktop\\tmp\\tree.txt";
-	args["i"] = "C:\\Users\\lafm2722\\Desktop\\tmp\\tree.txt";
-	*/
-
-	if (args.count("m") && args["m"] == "all_reroots") {
-		exec_all_reroots(args);
-	}
-
-
-
-	if (args.count("m") && args["m"] == "rnd") {
-		
-		string outfile = "";
-		int nbtrees = 2;
-		int nbleaves = 10;
-
-		if (args.count("t"))
-			nbtrees = Util::ToInt(args["t"]);
-
-		if (args.count("n"))
-			nbleaves = Util::ToInt(args["n"]);
-
-		ofstream outfile_stream;
-		if (args.count("o")) {
-			outfile = args["o"];
-			outfile_stream.open(outfile);
-		}
-
-		srand(time(NULL));
-		
-		vector<Node*> trees;
-
-		for (int i = 0; i < nbtrees; ++i) {
-			Node* v = new Node();
-			TreeUtil::get_random_binary_tree(v, nbleaves);
-			
-			//contract any edge to unroot
-			TreeUtil::contract_parent_edge(v->get_child(0));
-
-			TreeUtil::randomize_branch_lengths(v, 1.0, 10000.0);
-			trees.push_back(v);
-
-			string nw = NewickLex::ToNewickString(v, true);
-			nw = Util::ReplaceAll(nw, " ", "");
-
-
-
-
-			if (outfile == "")
-				cout << nw << endl;
-			else
-				outfile_stream << nw << endl;
-		}
-
-
-
-
-		TreePairInfo tpi(trees[0], trees[1]);
-		auto incomp = tpi.get_imcompats();
-
-		cout << "nb incompat=" << incomp.size();
-		/*for (auto it = incomp.begin(); it != incomp.end(); ++it) {
-			Node* v = (*it).first;
-			vector<Node*>& incs = (*it).second;
-
-			for (Node* w : incs) {
-				cout << "Incompat" << endl 
-					 << "v=" << tpi.infos[v].clade << "|" << tpi.infos[v].clade_comp << endl
-					 << "w=" << tpi.infos[w].clade << "|" << tpi.infos[w].clade_comp << endl;
-			}
-		}*/
-
-
-
-		if (outfile != "")
-			outfile_stream.close();
-
-		for (Node* v : trees)
-			delete v;
-
-
-	}
-	
-
-	return 0;
-}
-
-
-
+#include <set>
+#include <iostream>
+#include <time.h>
+#include <map>
+#include <string>
+#include <fstream>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <limits>
+
+
+#include "node.h"
+#include "newicklex.h"
+#include "treeutil.h"
+#include "treepairinfo.h"
+
+#include "BipartiteMWIS.h"
+#include "maxflowengines.h"
+#include "randomnewick.h"
+#include "treeperturb.h"
+#include "rfdistance.h"
+#include "hashrf.h"
+#include "consensus.h"
+#include "support.h"
+#include "tbe.h"
+#include "reconcile.h"
+#include "allrootings.h"
+#include "rooting.h"
+#include "topologyhash.h"
+#include "inducedsubtree.h"
+#include "patristic.h"
+#include "heavylight.h"
+#include "levelancestor.h"
+#include "labelindex.h"
+
+using namespace std;
+
+
+
+
+
+
+
+void exec_all_reroots(map<string, string>& args) {
+	string infilename = "";
+	if (args.count("i"))
+		infilename = args["i"];
+	else {
+		cout << "Please specify an input filename with -i [filename]" << endl;
+		return;
+	}
+
+	string outfilename = "";
+	if (args.count("o"))
+		outfilename = args["o"];
+
+	string incontent = Util::GetFileContent(infilename);
+	
+
+	if (incontent == "") {
+		cout << "Could not find newick string.  Make sure the specified file exists and is non-empty." << endl;
+		return;
+	}
+
+	Node* root = NewickLex::ParseNewickString(incontent);
+	vector<Node*> nodes = root->get_postordered_nodes();
+
+	string outstr = "";
+	
+	for (Node* v : nodes) {
+
+		if (v->is_root())
+			continue;
+
+		Node* w = TreeUtil::subdivide_parent_edge(v);
+		TreeUtil::reroot_on_node(w);
+
+		string newick = NewickLex::ToNewickString(w, true, true);
+		outstr += newick + "\n";
+
+		TreeUtil::reroot_on_node(root);
+		TreeUtil::contract_parent_edge(w);
+	}
+
+	if (outfilename == "")
+		cout << outstr;
+	else {
+		Util::WriteFileContent(outfilename, outstr);
+	}
+
+
+}
+
+
+
+
+
+/**
+  Computes the incompatibility graph between the first two trees of the input file.  Trees with different leaf
+  sets are first restricted to their common leaves.
+  -c only counts the incompatible pairs, -q only reports whether the trees are compatible.
+  Otherwise, the CSR graph is dumped in binary format to the -o file (or summarized on stdout if none).
+**/
+void exec_incompat(map<string, string>& args) {
+	if (!args.count("i")) {
+		cout << "Please specify an input filename with -i [filename]" << endl;
+		return;
+	}
+
+	vector<string> lines = Util::GetFileLines(args["i"]);
+	if (lines.size() < 2) {
+		cout << "The input file must contain at least two newick strings, one per line." << endl;
+		return;
+	}
+
+	Node* t1 = NewickLex::ParseNewickString(lines[0]);
+	Node* t2 = NewickLex::ParseNewickString(lines[1]);
+	if (InducedSubtreeBuilder::restrict_to_common_leaves(t1, t2) == 0) {
+		cout << "The two trees have no common leaf." << endl;
+		delete t1;
+		delete t2;
+		return;
+	}
+
+	TreePairInfo tpi(t1, t2);
+
+	if (args.count("q")) {
+		cout << (tpi.are_compatible() ? "compatible" : "incompatible") << endl;
+	}
+	else if (args.count("c")) {
+		cout << "nb incompat=" << tpi.count_incompats() << endl;
+	}
+	else {
+		IncompatGraph g = tpi.get_incompat_graph();
+		if (args.count("o")) {
+			if (!g.write_binary(args["o"]))
+				cout << "Could not write " << args["o"] << endl;
+		}
+		else {
+			cout << "n1=" << g.n1 << " n2=" << g.n2 << " nb incompat=" << g.get_nb_edges() << endl;
+		}
+	}
+
+	delete t1;
+	delete t2;
+}
+
+
+
+
+
+
+double get_node_weight(Node* v, const string& weighting) {
+	if (weighting == "length")
+		return v->branch_length;
+	if (weighting == "support")
+		return (Util::IsDouble(v->label) ? Util::ToDouble(v->label) : 0.0);
+	return 1.0;
+}
+
+
+
+/**
+  Finds a maximum weight set of pairwise compatible clades taken from the first two trees of the input file,
+  by solving the maximum weight independent set on their incompatibility graph (over their common leaves, as in
+  exec_incompat).
+  -w chooses the clade weights: unit (default), length (branch length) or support (internal node label).
+  Outputs the selected non-trivial clades, then the newick of their common refinement.
+**/
+void exec_mwis(map<string, string>& args) {
+	if (!args.count("i")) {
+		cout << "Please specify an input filename with -i [filename]" << endl;
+		return;
+	}
+
+	vector<string> lines = Util::GetFileLines(args["i"]);
+	if (lines.size() < 2) {
+		cout << "The input file must contain at least two newick strings, one per line." << endl;
+		return;
+	}
+
+	string weighting = "unit";
+	if (args.count("w"))
+		weighting = args["w"];
+
+	Node* t1 = NewickLex::ParseNewickString(lines[0]);
+	Node* t2 = NewickLex::ParseNewickString(lines[1]);
+	if (InducedSubtreeBuilder::restrict_to_common_leaves(t1, t2) == 0) {
+		cout << "The two trees have no common leaf." << endl;
+		delete t1;
+		delete t2;
+		return;
+	}
+
+	TreePairInfo tpi(t1, t2);
+	IncompatGraph g = tpi.get_incompat_graph();
+
+	vector<double> w1, w2;
+	for (Node* v : tpi.t1_nodes)
+		w1.push_back(get_node_weight(v, weighting));
+	for (Node* v : tpi.t2_nodes)
+		w2.push_back(get_node_weight(v, weighting));
+
+	vector<bool> in1, in2;
+	BipartiteMWIS::getMWIS(w1, w2, g, in1, in2);
+
+	string outstr = "";
+	double total = 0.0;
+	for (int t = 0; t < 2; ++t) {
+		vector<Node*>& nodes = (t == 0 ? tpi.t1_nodes : tpi.t2_nodes);
+		vector<bool>& in = (t == 0 ? in1 : in2);
+		vector<double>& w = (t == 0 ? w1 : w2);
+
+		for (size_t i = 0; i < nodes.size(); ++i) {
+			if (!in[i] || tpi.is_trivial(tpi.infos[nodes[i]]))
+				continue;
+			total += w[i];
+
+			string clade = "";
+			for (size_t leaf : tpi.infos[nodes[i]].clade) {
+				if (clade != "")
+					clade += ",";
+				clade += tpi.leafid_to_label[leaf];
+			}
+			outstr += "t" + Util::ToString(t + 1) + "\t" + Util::ToString(w[i]) + "\t" + clade + "\n";
+		}
+	}
+	outstr += "total_weight\t" + Util::ToString(total) + "\n";
+
+	Node* refinement = tpi.build_refinement(in1, in2);
+	outstr += NewickLex::ToNewickString(refinement, true) + "\n";
+
+	if (args.count("o"))
+		Util::WriteFileContent(args["o"], outstr);
+	else
+		cout << outstr;
+
+	delete refinement;
+	delete t1;
+	delete t2;
+}
+
+
+
+
+
+
+/**
+  Checks every max-flow engine against SimplePushRelabel, on random graphs and on the min-cut networks of the
+  incompatibility graphs of random tree pairs.  Also checks that the returned cut has the capacity of the flow,
+  and that PushRelabel::reoptimize matches a cold solve after capacity changes and edge insertions.
+  -t is the number of instances of each kind, -n the maximum number of vertices (resp. leaves), at least 4.
+  Instance i is generated from Rng::derive_seed(seed, i), with the seed -s, so a reported mismatch can be replayed.
+**/
+void exec_maxflow_check(map<string, string>& args) {
+	int nbinstances = 100;
+	int maxn = 50;
+	uint64 seed = time(NULL);
+	if (args.count("t") && !Util::ParseInt(args["t"], nbinstances)) {
+		cout << "The number of instances -t must be an integer" << endl;
+		return;
+	}
+	if (args.count("n") && !Util::ParseInt(args["n"], maxn)) {
+		cout << "The maximum size -n must be an integer" << endl;
+		return;
+	}
+	if (args.count("s") && !Util::ParseUInt64(args["s"], seed)) {
+		cout << "The seed -s must be a non-negative integer" << endl;
+		return;
+	}
+
+	if (maxn < 4) {
+		cout << "The maximum size -n must be at least 4" << endl;
+		return;
+	}
+
+	int nbruns = 0;
+	int nbfailed = 0;
+	for (int inst = 0; inst < 2 * nbinstances; ++inst) {
+		Rng rng(Rng::derive_seed(seed, inst));
+		int n;
+		vector<int> from, to;
+		vector<long long> caps;
+
+		if (inst < nbinstances) {
+			n = 2 + (int)rng.next_int(maxn - 1);
+			int m = (int)rng.next_int(4 * n);
+			for (int e = 0; e < m; ++e) {
+				from.push_back((int)rng.next_int(n));
+				to.push_back((int)rng.next_int(n));
+				caps.push_back((long long)rng.next_int(100));
+			}
+		}
+		else {
+			Node* t1 = new Node();
+			Node* t2 = new Node();
+			int nbleaves = 4 + (int)rng.next_int(maxn - 3);
+			TreeUtil::get_random_binary_tree(t1, nbleaves, rng);
+			TreeUtil::get_random_binary_tree(t2, nbleaves, rng);
+
+			TreePairInfo tpi(t1, t2);
+			IncompatGraph g = tpi.get_incompat_graph();
+			vector<long long> w1, w2;
+			for (uint64_t i = 0; i < g.n1; ++i)
+				w1.push_back(1 + (long long)rng.next_int(10));
+			for (uint64_t j = 0; j < g.n2; ++j)
+				w2.push_back(1 + (long long)rng.next_int(10));
+
+			vector<int> fid1, fid2;
+			n = BipartiteMWIS::map_vertices(g, fid1, fid2);
+			PushRelabel collect(n);
+			BipartiteMWIS::add_network_edges(collect, w1, w2, g, fid1, fid2);
+			from = collect.edge_from;
+			to = collect.edge_to;
+			caps = collect.edge_cap;
+
+			delete t1;
+			delete t2;
+		}
+
+		int s = 0;
+		int t = n - 1;
+		if (inst >= nbinstances)
+			t = 1;
+
+		SimplePushRelabel ref(n);
+		for (size_t e = 0; e < from.size(); ++e)
+			ref.addEdge(from[e], to[e], caps[e]);
+		long long expected = ref.max_flow(s, t);
+
+		for (string name : MaxFlowEngines::get_names()) {
+			MaxFlowSolver* flow = MaxFlowEngines::create(name, n);
+			for (size_t e = 0; e < from.size(); ++e)
+				flow->addEdge(from[e], to[e], caps[e]);
+
+			long long got = flow->max_flow(s, t);
+			nbruns++;
+
+			vector<bool> source_side(n, false);
+			for (int v : flow->getReachableBySource())
+				source_side[v] = true;
+			long long cut = 0;
+			for (size_t e = 0; e < from.size(); ++e)
+				if (source_side[from[e]] && !source_side[to[e]])
+					cut += caps[e];
+
+			if (expected != got || cut != got || !source_side[s] || source_side[t]) {
+				nbfailed++;
+				cout << "Mismatch for " << name << " on instance " << inst << ": n=" << n << " m=" << from.size()
+					<< " expected=" << expected << " got=" << got << " cut=" << cut << endl;
+			}
+
+			delete flow;
+		}
+
+		//warm started PushRelabel after a few rounds of capacity changes and edge insertions
+		PushRelabel incremental(n);
+		for (size_t e = 0; e < from.size(); ++e)
+			incremental.addEdge(from[e], to[e], caps[e]);
+		incremental.max_flow(s, t);
+		for (int round = 0; round < 3 && !from.empty(); ++round) {
+			for (int k = 0; k < 3; ++k) {
+				int e = (int)rng.next_int(from.size());
+				caps[e] = (inst < nbinstances ? (long long)rng.next_int(100) : caps[e] / 2 + (long long)rng.next_int(10));
+				incremental.set_capacity(e, caps[e]);
+			}
+			if (inst < nbinstances) {
+				from.push_back((int)rng.next_int(n));
+				to.push_back((int)rng.next_int(n));
+				caps.push_back((long long)rng.next_int(100));
+				incremental.addEdge(from.back(), to.back(), caps.back());
+			}
+
+			SimplePushRelabel cold(n);
+			for (size_t e = 0; e < from.size(); ++e)
+				cold.addEdge(from[e], to[e], caps[e]);
+			long long expected_after = cold.max_flow(s, t);
+			long long got = incremental.reoptimize();
+			nbruns++;
+			if (expected_after != got) {
+				nbfailed++;
+				cout << "Mismatch for incremental pushrelabel on instance " << inst << " round " << round
+					<< ": expected=" << expected_after << " got=" << got << endl;
+			}
+		}
+	}
+
+	cout << (nbruns - nbfailed) << "/" << nbruns << " runs ok (seed " << seed << ")" << endl;
+}
+
+
+
+
+
+
+/**
+  Random binary tree.  Trees of models with branch lengths (coalescent, birthdeath) are kept rooted and
+  ultrametric; the others are unrooted and get uniform branch lengths.  Returns nullptr if the model is unknown
+  or its parameters are invalid.
+**/
+Node* get_random_tree(int nbleaves, const string& model, Rng& rng, double birth, double death) {
+	Node* v = new Node();
+	if (!TreeUtil::get_random_tree(v, nbleaves, model, rng, birth, death)) {
+		delete v;
+		return nullptr;
+	}
+
+	if (!TreeUtil::has_branch_lengths(model)) {
+		//contract an internal child edge to unroot (contracting a leaf edge would remove the leaf)
+		if (v->get_nb_children() == 2) {
+			Node* c = v->get_child(0)->is_leaf() ? v->get_child(1) : v->get_child(0);
+			if (!c->is_leaf())
+				TreeUtil::contract_parent_edge(c);
+		}
+
+		TreeUtil::randomize_branch_lengths(v, 1.0, 10000.0, rng);
+	}
+
+	return v;
+}
+
+
+
+/**
+  Same as above, as a newick string, or "" if the model is unknown or its parameters are invalid.
+**/
+string get_random_newick(int nbleaves, const string& model, Rng& rng, double birth, double death) {
+	Node* v = get_random_tree(nbleaves, model, rng, birth, death);
+	if (!v)
+		return "";
+
+	string nw = NewickLex::ToNewickString(v, true);
+	delete v;
+	return Util::ReplaceAll(nw, " ", "");
+}
+
+
+
+
+
+/**
+  Generates -t random trees on -n leaves with model -g (see TreeUtil::get_random_tree), using -p threads
+  (default: all cores).  -b and -d are the speciation and extinction rates of the birthdeath model.
+  Tree i is generated from Rng::derive_seed(seed, i), so the output only depends on -s, not on the number of
+  threads.  Trees are written in order as soon as they are ready; at most a few per thread are held in memory.
+  With -stream, trees are written by RandomNewickWriter one after the other instead, which handles any number
+  of leaves in O(height) memory.
+**/
+void exec_rnd(map<string, string>& args) {
+	string outfile = "";
+	int nbtrees = 2;
+	long long nbleaves = 10;
+	string model = "split";
+	uint64 seed = time(NULL);
+	int nbthreads = max(1, (int)thread::hardware_concurrency());
+	double birth = 1.0;
+	double death = 0.0;
+
+	if (args.count("t"))
+		nbtrees = Util::ToInt(args["t"]);
+
+	if (args.count("n") && !Util::ParseLongLong(args["n"], nbleaves)) {
+		cout << "The number of leaves -n must be an integer" << endl;
+		return;
+	}
+
+	if (args.count("g"))
+		model = args["g"];
+
+	if (args.count("s") && !Util::ParseUInt64(args["s"], seed)) {
+		cout << "The seed -s must be a non-negative integer" << endl;
+		return;
+	}
+
+	if (args.count("p"))
+		nbthreads = max(1, Util::ToInt(args["p"]));
+
+	if (args.count("b"))
+		birth = Util::ToDouble(args["b"]);
+
+	if (args.count("d"))
+		death = Util::ToDouble(args["d"]);
+
+	if (nbleaves < 1) {
+		cout << "The number of leaves -n must be at least 1" << endl;
+		return;
+	}
+
+	//trees are built with int node counts, only the streaming writer goes beyond
+	if (!args.count("stream") && nbleaves > numeric_limits<int>::max()) {
+		cout << "More than " << numeric_limits<int>::max() << " leaves requires -stream" << endl;
+		return;
+	}
+
+	{
+		Node tmp;
+		Rng rng;
+		if (!TreeUtil::get_random_tree(&tmp, 1, model, rng, birth, death)) {
+			cout << "Unknown model " << model << " or invalid rates, use split, uniform, pda, yule, caterpillar, balanced, "
+				<< "coalescent or birthdeath (with -b birth > -d death >= 0)" << endl;
+			return;
+		}
+		if (args.count("stream") && !RandomNewickWriter::is_model(model)) {
+			cout << "Model " << model << " cannot be streamed" << endl;
+			return;
+		}
+	}
+
+	ofstream outfile_stream;
+	if (args.count("o")) {
+		outfile = args["o"];
+		outfile_stream.open(outfile);
+	}
+	ostream& out = (outfile == "" ? cout : outfile_stream);
+
+	//streaming: newicks are written while the trees are drawn, without building them, so there is no size limit
+	if (args.count("stream")) {
+		for (int i = 0; i < nbtrees; ++i) {
+			Rng rng(Rng::derive_seed(seed, i));
+			RandomNewickWriter writer(model, rng, out);
+			writer.write_tree(nbleaves);
+		}
+		out.flush();
+		return;
+	}
+
+	nbthreads = min(nbthreads, max(1, nbtrees));
+
+	//tree i goes to slot i % window, and may only be generated once tree i - window has been written
+	int window = 4 * nbthreads;
+	vector<string> slots(window);
+	vector<bool> ready(window, false);
+	int nbwritten = 0;
+	atomic<int> next_tree(0);
+	mutex m;
+	condition_variable cv_ready, cv_space;
+
+	auto worker = [&]() {
+		while (true) {
+			int i = next_tree++;
+			if (i >= nbtrees)
+				break;
+
+			{
+				unique_lock<mutex> lock(m);
+				cv_space.wait(lock, [&] { return i < nbwritten + window; });
+			}
+
+			Rng rng(Rng::derive_seed(seed, i));
+			string nw = get_random_newick((int)nbleaves, model, rng, birth, death);
+
+			{
+				lock_guard<mutex> lock(m);
+				slots[i % window] = move(nw);
+				ready[i % window] = true;
+			}
+			cv_ready.notify_one();
+		}
+	};
+
+	vector<thread> threads;
+	for (int t = 0; t < nbthreads; ++t)
+		threads.push_back(thread(worker));
+
+	for (int i = 0; i < nbtrees; ++i) {
+		string nw;
+		{
+			unique_lock<mutex> lock(m);
+			cv_ready.wait(lock, [&] { return (bool)ready[i % window]; });
+			nw = move(slots[i % window]);
+			slots[i % window].clear();
+			ready[i % window] = false;
+			nbwritten = i + 1;
+		}
+		cv_space.notify_all();
+
+		out << nw << "\n";
+	}
+	out.flush();
+
+	for (thread& t : threads)
+		t.join();
+
+	if (outfile != "")
+		outfile_stream.close();
+}
+
+
+
+
+
+
+/**
+  Writes a tree followed by -t perturbed copies of it, each obtained by applying -k random moves of type -x
+  (nni, spr or tbr, default spr) with TreePerturber, so that tree pairs at a controlled distance can be produced.
+  The tree is the first of the -i file, or else a random tree on -n leaves of model -g (see exec_rnd).
+  Copy i uses Rng::derive_seed(seed, i), so the output only depends on -s (default: current time).
+**/
+void exec_perturb(map<string, string>& args) {
+	int nbcopies = 1;
+	int nbmoves = 1;
+	string move = "spr";
+	uint64 seed = time(NULL);
+
+	if (args.count("t"))
+		nbcopies = Util::ToInt(args["t"]);
+
+	if (args.count("k"))
+		nbmoves = Util::ToInt(args["k"]);
+
+	if (args.count("x"))
+		move = args["x"];
+
+	if (args.count("s") && !Util::ParseUInt64(args["s"], seed)) {
+		cout << "The seed -s must be a non-negative integer" << endl;
+		return;
+	}
+
+	if (move != "nni" && move != "spr" && move != "tbr") {
+		cout << "Unknown move " << move << ", use nni, spr or tbr" << endl;
+		return;
+	}
+
+	Node* tree = nullptr;
+	if (args.count("i")) {
+		vector<string> lines = Util::GetFileLines(args["i"]);
+		if (lines.empty()) {
+			cout << "Could not find newick string.  Make sure the specified file exists and is non-empty." << endl;
+			return;
+		}
+		tree = NewickLex::ParseNewickString(lines[0]);
+	}
+	else {
+		int nbleaves = 10;
+		string model = (args.count("g") ? args["g"] : "split");
+		if (args.count("n") && !Util::ParseInt(args["n"], nbleaves)) {
+			cout << "The number of leaves -n must be an integer" << endl;
+			return;
+		}
+		if (nbleaves < 1) {
+			cout << "The number of leaves -n must be at least 1" << endl;
+			return;
+		}
+
+		Rng rng(Rng::derive_seed(seed, 0));
+		tree = get_random_tree(nbleaves, model, rng, 1.0, 0.0);
+		if (!tree) {
+			cout << "Unknown model " << model << endl;
+			return;
+		}
+	}
+
+	ofstream outfile_stream;
+	if (args.count("o"))
+		outfile_stream.open(args["o"]);
+	ostream& out = (args.count("o") ? outfile_stream : cout);
+
+	out << Util::ReplaceAll(NewickLex::ToNewickString(tree, true), " ", "") << "\n";
+
+	for (int i = 1; i <= nbcopies; ++i) {
+		Node* copy = new Node(*tree);
+		Rng rng(Rng::derive_seed(seed, i));
+		TreePerturber perturber(copy, rng);
+		int nbdone = perturber.perturb(nbmoves, move);
+		if (nbdone < nbmoves)
+			cerr << "Copy " << i << ": only " << nbdone << " moves could be applied" << endl;
+
+		out << Util::ReplaceAll(NewickLex::ToNewickString(copy, true), " ", "") << "\n";
+		delete copy;
+	}
+	out.flush();
+
+	delete tree;
+}
+
+
+
+
+
+
+/**
+  Robinson-Foulds distance between the first tree of the -i file and each of the following ones, one per line
+  (-1 if the leaf sets differ).  Trees are compared as unrooted, or as rooted with -rooted.  Distances use
+  bipartition hashing, or the collision-free algorithm with -exact.
+**/
+void exec_rf(map<string, string>& args) {
+	if (!args.count("i")) {
+		cout << "Please specify an input filename with -i [filename]" << endl;
+		return;
+	}
+
+	bool rooted = args.count("rooted");
+	bool exact = args.count("exact");
+
+	ifstream in(args["i"]);
+	Node* first = NewickLex::ReadNextTree(in);
+	if (!first) {
+		cout << "Could not find newick string.  Make sure the specified file exists and is non-empty." << endl;
+		return;
+	}
+
+	ofstream outfile_stream;
+	if (args.count("o"))
+		outfile_stream.open(args["o"]);
+	ostream& out = (args.count("o") ? outfile_stream : cout);
+
+	Node* tree;
+	while ((tree = NewickLex::ReadNextTree(in))) {
+		out << RFDistance::get_rf(first, tree, rooted, exact) << "\n";
+		delete tree;
+	}
+	out.flush();
+
+	delete first;
+}
+
+
+
+
+
+
+/**
+  All-pairs Robinson-Foulds distance matrix of the trees of the -i file (see HashRF), written as text, or in binary
+  with -b, to the -o file or stdout.  Trees are compared as unrooted unless -rooted is given.  -p is the number of
+  threads (default: all cores).  Trees whose leaf set differs from the first tree are skipped with a warning.
+**/
+void exec_rfmatrix(map<string, string>& args) {
+	if (!args.count("i")) {
+		cout << "Please specify an input filename with -i [filename]" << endl;
+		return;
+	}
+
+	int nbthreads = max(1, (int)thread::hardware_concurrency());
+	if (args.count("p"))
+		nbthreads = max(1, Util::ToInt(args["p"]));
+
+	HashRF hashrf(args.count("rooted"));
+
+	ifstream in(args["i"]);
+	Node* tree;
+	int cpt = 0;
+	while ((tree = NewickLex::ReadNextTree(in))) {
+		if (!hashrf.add_tree(tree))
+			cerr << "Tree " << cpt << " does not have the leaf set of the first tree, skipped" << endl;
+		delete tree;
+		cpt++;
+	}
+
+	if (hashrf.get_nb_trees() == 0) {
+		cout << "Could not find newick string.  Make sure the specified file exists and is non-empty." << endl;
+		return;
+	}
+
+	ofstream outfile_stream;
+	if (args.count("o"))
+		outfile_stream.open(args["o"], ios::binary);
+	ostream& out = (args.count("o") ? outfile_stream : cout);
+
+	hashrf.write_matrix(out, args.count("b"), nbthreads);
+}
+
+
+
+
+
+
+/**
+  Consensus tree of the trees of the -i file (see ConsensusBuilder), with -c strict, majority (default) or greedy.
+  -t is the majority threshold (default 0.5).  With -f e, splits of frequency below e are dropped along the way to
+  bound memory, and reported frequencies may be underestimated by at most e.  Trees are unrooted unless -rooted
+  is given.  Internal labels are split frequencies.
+**/
+void exec_consensus(map<string, string>& args) {
+	if (!args.count("i")) {
+		cout << "Please specify an input filename with -i [filename]" << endl;
+		return;
+	}
+
+	string method = (args.count("c") ? args["c"] : "majority");
+	if (method != "strict" && method != "majority" && method != "greedy") {
+		cout << "Unknown consensus method " << method << ", use strict, majority or greedy" << endl;
+		return;
+	}
+	double threshold = (args.count("t") ? Util::ToDouble(args["t"]) : 0.5);
+	double min_frequency = (args.count("f") ? Util::ToDouble(args["f"]) : 0.0);
+
+	ConsensusBuilder builder(args.count("rooted"), min_frequency);
+
+	ifstream in(args["i"]);
+	Node* tree;
+	int cpt = 0;
+	while ((tree = NewickLex::ReadNextTree(in))) {
+		if (!builder.add_tree(tree))
+			cerr << "Tree " << cpt << " does not have the leaf set of the first tree, skipped" << endl;
+		delete tree;
+		cpt++;
+	}
+
+	if (builder.get_nb_trees() == 0) {
+		cout << "Could not find newick string.  Make sure the specified file exists and is non-empty." << endl;
+		return;
+	}
+
+	Node* consensus = builder.get_consensus(method, threshold);
+	string newick = NewickLex::ToNewickString(consensus);
+	delete consensus;
+
+	if (args.count("o")) {
+		ofstream outfile(args["o"]);
+		outfile << newick << endl;
+	}
+	else {
+		cout << newick << endl;
+	}
+}
+
+
+
+
+
+
+/**
+  Writes the first tree of the -i file with the bootstrap support of its splits as internal labels (see SplitSupport),
+  computed from the replicate trees of the -r file with -p threads (default: all cores).  Trees are unrooted
+  unless -rooted is given.  With -tbe, supports are transfer bootstrap expectations instead (see TransferSupport).
+  Replicates whose leaf set differs from the reference are skipped with a warning.
+**/
+void exec_support(map<string, string>& args) {
+	if (!args.count("i") || !args.count("r")) {
+		cout << "Please specify a reference tree file with -i [filename] and a replicates file with -r [filename]" << endl;
+		return;
+	}
+
+	int nbthreads = max(1, (int)thread::hardware_concurrency());
+	if (args.count("p"))
+		nbthreads = max(1, Util::ToInt(args["p"]));
+
+	ifstream in(args["i"]);
+	Node* reference = NewickLex::ReadNextTree(in);
+	if (!reference) {
+		cout << "Could not find newick string.  Make sure the specified file exists and is non-empty." << endl;
+		return;
+	}
+
+	ifstream replicates(args["r"]);
+	long long nbskipped = 0;
+	if (args.count("tbe")) {
+		TransferSupport support(reference);
+		nbskipped = support.add_replicates(replicates, nbthreads);
+		support.annotate_reference();
+	}
+	else {
+		SplitSupport support(reference, args.count("rooted"));
+		nbskipped = support.add_replicates(replicates, nbthreads);
+		support.annotate_reference();
+	}
+	if (nbskipped > 0)
+		cerr << nbskipped << " replicates do not have the leaf set of the reference tree, skipped" << endl;
+
+	string newick = NewickLex::ToNewickString(reference, true);
+	delete reference;
+
+	if (args.count("o")) {
+		ofstream outfile(args["o"]);
+		outfile << newick << endl;
+	}
+	else {
+		cout << newick << endl;
+	}
+}
+
+
+
+
+
+
+/**
+  Reconciles each gene tree of the -i file with the species tree of the -sp file (see Reconciler), and writes
+  one line per gene tree, in input order, with its number of duplications and losses separated by a tab, or NA
+  if the species of one of its leaves is not in the species tree.  The species of a gene leaf is extracted from
+  its label with the regular expression -r (see SpeciesExtractor, default: the whole label).  Gene trees are
+  processed by -p threads (default: all cores), which share the LCA index of the species tree.
+**/
+void exec_reconcile(map<string, string>& args) {
+	if (!args.count("i") || !args.count("sp")) {
+		cout << "Please specify a gene trees file with -i [filename] and a species tree file with -sp [filename]" << endl;
+		return;
+	}
+
+	int nbthreads = max(1, (int)thread::hardware_concurrency());
+	if (args.count("p"))
+		nbthreads = max(1, Util::ToInt(args["p"]));
+
+	ifstream species_in(args["sp"]);
+	Node* species_tree = NewickLex::ReadNextTree(species_in);
+	if (!species_tree) {
+		cout << "Could not find the species tree newick string." << endl;
+		return;
+	}
+
+	SpeciesExtractor extractor;
+	try {
+		extractor = SpeciesExtractor(args.count("r") ? args["r"] : "");
+	}
+	catch (regex_error& e) {
+		cout << "Invalid species regular expression " << args["r"] << endl;
+		delete species_tree;
+		return;
+	}
+
+	LCAIndex species_index(species_tree);
+	Reconciler reconciler(species_index, extractor);
+
+	vector<vector<pair<long long, string>>> thread_lines(nbthreads);
+	ifstream in(args["i"]);
+	ParallelTreeReader::for_each_tree(in, nbthreads, [&](Node* tree, int t, long long i) {
+		Reconciler::Result result;
+		string line = "NA";
+		if (reconciler.reconcile(tree, result))
+			line = Util::ToString(result.nb_duplications) + "\t" + Util::ToString(result.nb_losses);
+		thread_lines[t].push_back(make_pair(i, line));
+	});
+
+	vector<pair<long long, string>> lines;
+	for (auto& tl : thread_lines)
+		lines.insert(lines.end(), tl.begin(), tl.end());
+	sort(lines.begin(), lines.end());
+
+	ofstream outfile_stream;
+	if (args.count("o"))
+		outfile_stream.open(args["o"]);
+	ostream& out = (args.count("o") ? outfile_stream : cout);
+	for (auto& l : lines)
+		out << l.second << "\n";
+	out.flush();
+
+	delete species_tree;
+}
+
+
+
+
+
+
+/**
+  Roots each gene tree of the -i file, seen as unrooted, to minimize its reconciliation cost with the species
+  tree of the -sp file (see Reconciler::reconcile_all_rootings), in O(n) for all the rootings.  The cost -c is
+  dup, loss or dl (duplications plus losses, the default).  Writes the best rooting of each gene tree (the first
+  one in case of ties), or with -all, one line per gene tree with the cost of each rooting, in the order of
+  all_reroots.  Gene trees with unknown species give NA.  -r and -p are as in exec_reconcile.
+**/
+void exec_dlroot(map<string, string>& args) {
+	if (!args.count("i") || !args.count("sp")) {
+		cout << "Please specify a gene trees file with -i [filename] and a species tree file with -sp [filename]" << endl;
+		return;
+	}
+
+	string cost = (args.count("c") ? args["c"] : "dl");
+	if (cost != "dup" && cost != "loss" && cost != "dl") {
+		cout << "Unknown cost " << cost << ", use dup, loss or dl" << endl;
+		return;
+	}
+	bool all = args.count("all");
+
+	int nbthreads = max(1, (int)thread::hardware_concurrency());
+	if (args.count("p"))
+		nbthreads = max(1, Util::ToInt(args["p"]));
+
+	ifstream species_in(args["sp"]);
+	Node* species_tree = NewickLex::ReadNextTree(species_in);
+	if (!species_tree) {
+		cout << "Could not find the species tree newick string." << endl;
+		return;
+	}
+
+	SpeciesExtractor extractor;
+	try {
+		extractor = SpeciesExtractor(args.count("r") ? args["r"] : "");
+	}
+	catch (regex_error& e) {
+		cout << "Invalid species regular expression " << args["r"] << endl;
+		delete species_tree;
+		return;
+	}
+
+	LCAIndex species_index(species_tree);
+	Reconciler reconciler(species_index, extractor);
+
+	vector<vector<pair<long long, string>>> thread_lines(nbthreads);
+	ifstream in(args["i"]);
+	ParallelTreeReader::for_each_tree(in, nbthreads, [&](Node* tree, int t, long long i) {
+		vector<Node*> nodes = tree->get_postordered_nodes();
+		vector<Reconciler::Result> results = reconciler.reconcile_all_rootings(tree);
+		if (results.empty()) {
+			thread_lines[t].push_back(make_pair(i, "NA"));
+			return;
+		}
+
+		string line = "";
+		long long best_cost = -1;
+		int best = -1;
+		for (size_t k = 0; k < nodes.size(); ++k) {
+			if (nodes[k]->is_root())
+				continue;
+			long long c = (cost == "dup" ? results[k].nb_duplications :
+			               cost == "loss" ? results[k].nb_losses : results[k].nb_duplications + results[k].nb_losses);
+			if (all)
+				line += (line == "" ? "" : " ") + Util::ToString((int)c);
+			if (best == -1 || c < best_cost) {
+				best_cost = c;
+				best = k;
+			}
+		}
+
+		if (!all) {
+			//the reader deletes tree through its root, so the rerooting is done on a copy
+			Node* copy = new Node(*tree);
+			Node* root = copy;
+			if (best != -1)
+				root = TreeUtil::reroot_on_edge(copy->get_postordered_nodes()[best]);
+			line = NewickLex::ToNewickString(root, true);
+			delete root;
+		}
+		thread_lines[t].push_back(make_pair(i, line));
+	});
+
+	vector<pair<long long, string>> lines;
+	for (auto& tl : thread_lines)
+		lines.insert(lines.end(), tl.begin(), tl.end());
+	sort(lines.begin(), lines.end());
+
+	ofstream outfile_stream;
+	if (args.count("o"))
+		outfile_stream.open(args["o"]);
+	ostream& out = (args.count("o") ? outfile_stream : cout);
+	for (auto& l : lines)
+		out << l.second << "\n";
+	out.flush();
+
+	delete species_tree;
+}
+
+
+
+
+
+
+/**
+  For each tree of the -i file, writes one line with a statistic -s of each of its rootings, in the order of
+  all_reroots, computed for all the rootings at once with AllRootings.  The root is placed in the middle of each
+  edge.  Statistics: height (maximum root to leaf distance, the default), pathlength (sum of root to leaf
+  distances), sackin (sum of leaf depths) and colless.  -nolengths uses unit branch lengths for height and
+  pathlength.
+**/
+void exec_reroot_stats(map<string, string>& args) {
+	if (!args.count("i")) {
+		cout << "Please specify an input filename with -i [filename]" << endl;
+		return;
+	}
+
+	string statname = (args.count("s") ? args["s"] : "height");
+	if (statname != "height" && statname != "pathlength" && statname != "sackin" && statname != "colless") {
+		cout << "Unknown statistic " << statname << ", use height, pathlength, sackin or colless" << endl;
+		return;
+	}
+	bool use_lengths = !args.count("nolengths");
+
+	ofstream outfile_stream;
+	if (args.count("o"))
+		outfile_stream.open(args["o"]);
+	ostream& out = (args.count("o") ? outfile_stream : cout);
+
+	ifstream in(args["i"]);
+	Node* tree;
+	while ((tree = NewickLex::ReadNextTree(in))) {
+		vector<double> values;
+		if (statname == "height") {
+			HeightStat stat(use_lengths);
+			values = AllRootings<HeightStat>::compute(tree, stat);
+		}
+		else if (statname == "pathlength" || statname == "sackin") {
+			PathLengthStat stat(use_lengths && statname == "pathlength");
+			for (auto& v : AllRootings<PathLengthStat>::compute(tree, stat))
+				values.push_back(v.sum);
+		}
+		else {
+			CollessStat stat;
+			for (auto& v : AllRootings<CollessStat>::compute(tree, stat))
+				values.push_back(v.colless);
+		}
+
+		vector<Node*> nodes = tree->get_postordered_nodes();
+		string line = "";
+		for (size_t k = 0; k < nodes.size(); ++k) {
+			if (nodes[k]->is_root())
+				continue;
+			line += (line == "" ? "" : " ") + Util::ToString(values[k]);
+		}
+		out << line << "\n";
+
+		delete tree;
+	}
+	out.flush();
+}
+
+
+
+
+
+
+/**
+  Roots each tree of the -i file, seen as unrooted, with method -x: midpoint (middle of the longest leaf to leaf
+  path), minvar (minimum variance of the root to leaf distances, the default) or mad (minimal ancestor deviation,
+  quadratic in the number of leaves), and writes the rerooted trees.  For each tree, the chosen edge (as the
+  index of its lower node in postorder, as in all_reroots), the distance of the root from that node and the score
+  of the method are reported on stderr.
+**/
+void exec_root(map<string, string>& args) {
+	if (!args.count("i")) {
+		cout << "Please specify an input filename with -i [filename]" << endl;
+		return;
+	}
+
+	string method = (args.count("x") ? args["x"] : "minvar");
+	if (method != "midpoint" && method != "minvar" && method != "mad") {
+		cout << "Unknown rooting method " << method << ", use midpoint, minvar or mad" << endl;
+		return;
+	}
+
+	ofstream outfile_stream;
+	if (args.count("o"))
+		outfile_stream.open(args["o"]);
+	ostream& out = (args.count("o") ? outfile_stream : cout);
+
+	ifstream in(args["i"]);
+	Node* tree;
+	while ((tree = NewickLex::ReadNextTree(in))) {
+		TreeRooting::RootPosition pos;
+		vector<Node*> nodes = tree->get_postordered_nodes();
+		Node* root = TreeRooting::reroot(tree, method, pos);
+
+		if (pos.node) {
+			int edge = find(nodes.begin(), nodes.end(), pos.node) - nodes.begin();
+			cerr << "edge=" << edge << " distance=" << pos.distance << " score=" << pos.score << endl;
+		}
+		else {
+			cerr << "NA" << endl;
+		}
+
+		out << NewickLex::ToNewickString(root, true) << "\n";
+		delete root;
+	}
+	out.flush();
+}
+
+
+
+
+
+
+/**
+  Counts the distinct topologies of the trees of the -i file, compared with TopologyHasher as unrooted trees, or
+  rooted with -rooted, and with their branch lengths with -lengths.  Writes one line per topology, by decreasing
+  frequency (then by first occurrence): its number of trees, the index of its first tree in the file and that
+  tree.  Trees are hashed by -p threads (default: all cores).
+**/
+void exec_dedup(map<string, string>& args) {
+	if (!args.count("i")) {
+		cout << "Please specify an input filename with -i [filename]" << endl;
+		return;
+	}
+
+	bool rooted = args.count("rooted");
+	TopologyHasher hasher(args.count("lengths"));
+	int nbthreads = max(1, (int)thread::hardware_concurrency());
+	if (args.count("p"))
+		nbthreads = max(1, Util::ToInt(args["p"]));
+
+	struct Topology {
+		long long count = 0;
+		long long first = -1;
+		string newick;
+	};
+
+	vector<unordered_map<uint64, Topology>> thread_topologies(nbthreads);
+	ifstream in(args["i"]);
+	long long nbtrees = ParallelTreeReader::for_each_tree(in, nbthreads, [&](Node* tree, int t, long long i) {
+		Topology& topology = thread_topologies[t][hasher.get_hash(tree, rooted)];
+		topology.count++;
+		if (topology.first == -1 || i < topology.first) {
+			topology.first = i;
+			topology.newick = NewickLex::ToNewickString(tree, true);
+		}
+	});
+
+	unordered_map<uint64, Topology> topologies;
+	for (auto& tt : thread_topologies) {
+		for (auto& h : tt) {
+			Topology& topology = topologies[h.first];
+			topology.count += h.second.count;
+			if (topology.first == -1 || h.second.first < topology.first) {
+				topology.first = h.second.first;
+				topology.newick = move(h.second.newick);
+			}
+		}
+	}
+
+	vector<Topology*> sorted;
+	for (auto& h : topologies)
+		sorted.push_back(&h.second);
+	sort(sorted.begin(), sorted.end(), [](Topology* a, Topology* b) {
+		return (a->count != b->count ? a->count > b->count : a->first < b->first);
+	});
+
+	ofstream outfile_stream;
+	if (args.count("o"))
+		outfile_stream.open(args["o"]);
+	ostream& out = (args.count("o") ? outfile_stream : cout);
+	for (Topology* topology : sorted)
+		out << topology->count << "\t" << topology->first << "\t" << topology->newick << "\n";
+	out.flush();
+
+	cerr << nbtrees << " trees, " << sorted.size() << " distinct topologies" << endl;
+}
+
+
+
+
+
+
+/**
+  Writes each tree of the -i file restricted to the leaves listed in the -l file (one label per line), with
+  InducedSubtreeBuilder: nodes of degree 2 are suppressed and their branch lengths summed.  Labels that are
+  not in a tree are ignored, and a tree with none of the labels gives an empty line.
+**/
+void exec_restrict(map<string, string>& args) {
+	if (!args.count("i") || !args.count("l")) {
+		cout << "Please specify an input filename with -i [filename] and a leaf labels file with -l [filename]" << endl;
+		return;
+	}
+
+	vector<string> labels;
+	for (string& line : Util::GetFileLines(args["l"])) {
+		string label = Util::Trim(line);
+		if (label != "")
+			labels.push_back(label);
+	}
+
+	ofstream outfile_stream;
+	if (args.count("o"))
+		outfile_stream.open(args["o"]);
+	ostream& out = (args.count("o") ? outfile_stream : cout);
+
+	ifstream in(args["i"]);
+	Node* tree;
+	while ((tree = NewickLex::ReadNextTree(in))) {
+		LCAIndex index(tree);
+		InducedSubtreeBuilder builder(index);
+		Node* restricted = builder.build(labels);
+		if (restricted) {
+			out << NewickLex::ToNewickString(restricted, true);
+			delete restricted;
+		}
+		out << "\n";
+		delete tree;
+	}
+	out.flush();
+}
+
+
+
+
+
+
+/**
+  Patristic distances between the leaves of the first tree of the -i file (see PatristicDistances).  With -q, reads
+  one pair of leaf labels per line of the -q file (separated by spaces or tabs) and writes their distance, or NA
+  if a label is unknown.  Otherwise writes the full leaf distance matrix in format -f: phylip (the default) or
+  binary, with float values if -float is given, filled by -p threads (default: all cores).
+**/
+void exec_patristic(map<string, string>& args) {
+	if (!args.count("i")) {
+		cout << "Please specify an input filename with -i [filename]" << endl;
+		return;
+	}
+
+	string format = (args.count("f") ? args["f"] : "phylip");
+	if (format != "phylip" && format != "binary") {
+		cout << "Unknown matrix format " << format << ", use phylip or binary" << endl;
+		return;
+	}
+	int nbthreads = max(1, (int)thread::hardware_concurrency());
+	if (args.count("p"))
+		nbthreads = max(1, Util::ToInt(args["p"]));
+
+	ifstream in(args["i"]);
+	Node* tree = NewickLex::ReadNextTree(in);
+	if (!tree) {
+		cout << "Could not find newick string.  Make sure the specified file exists and is non-empty." << endl;
+		return;
+	}
+	PatristicDistances distances(tree);
+
+	ofstream outfile_stream;
+	if (args.count("o"))
+		outfile_stream.open(args["o"], (format == "binary" ? ios::binary : ios::out));
+	ostream& out = (args.count("o") ? outfile_stream : cout);
+
+	if (args.count("q")) {
+		for (string& line : Util::GetFileLines(args["q"])) {
+			istringstream pair(line);
+			string a, b;
+			if (!(pair >> a >> b))
+				continue;
+			double d = distances.get_distance(a, b);
+			out << (d < 0 ? "NA" : Util::ToString(d)) << "\n";
+		}
+		out.flush();
+	}
+	else if (!distances.write_matrix(out, format, args.count("float"), nbthreads)) {
+		cout << "Could not write the distance matrix" << endl;
+	}
+
+	delete tree;
+}
+
+
+
+
+
+
+/**
+  Path queries on the first tree of the -i file, for the pairs of leaf labels of the -q file (one pair per line,
+  separated by spaces or tabs), with a HeavyLightIndex.  Each edge has the value -v of its lower node: length
+  (branch length, the default), support (internal node label, 0 if not a number) or unit.  Writes one line per
+  pair with the number of edges of the path, and the sum, min and max of their values, or NA if a label is
+  unknown.
+**/
+void exec_pathquery(map<string, string>& args) {
+	if (!args.count("i") || !args.count("q")) {
+		cout << "Please specify a tree file with -i [filename] and a label pairs file with -q [filename]" << endl;
+		return;
+	}
+
+	string weighting = (args.count("v") ? args["v"] : "length");
+	if (weighting != "length" && weighting != "support" && weighting != "unit") {
+		cout << "Unknown value " << weighting << ", use length, support or unit" << endl;
+		return;
+	}
+
+	ifstream in(args["i"]);
+	Node* tree = NewickLex::ReadNextTree(in);
+	if (!tree) {
+		cout << "Could not find newick string.  Make sure the specified file exists and is non-empty." << endl;
+		return;
+	}
+
+	HeavyLightIndex index(tree);
+	index.set_values([&](Node* v) { return get_node_weight(v, weighting); });
+	LabelIndex labels(tree);
+
+	ofstream outfile_stream;
+	if (args.count("o"))
+		outfile_stream.open(args["o"]);
+	ostream& out = (args.count("o") ? outfile_stream : cout);
+
+	for (string& line : Util::GetFileLines(args["q"])) {
+		istringstream pair(line);
+		string a, b;
+		if (!(pair >> a >> b))
+			continue;
+		Node* va = labels.find(a);
+		Node* vb = labels.find(b);
+		if (!va || !vb) {
+			out << "NA\n";
+			continue;
+		}
+		HeavyLightIndex::PathAggregate path = index.query_path(index.get_id(va), index.get_id(vb), true);
+		if (path.nb_nodes == 0)
+			out << "0\t0\tNA\tNA\n";
+		else
+			out << path.nb_nodes << "\t" << path.sum << "\t" << path.min << "\t" << path.max << "\n";
+	}
+	out.flush();
+
+	delete tree;
+}
+
+
+
+
+
+
+/**
+  Clusters the leaves of each tree of the -i file by cutting it at distance -t from the root (each part below
+  the cut is a cluster, and leaves closer than -t to the root are alone), or with -k, at depth k (the clusters
+  are the subtrees of the nodes k edges below the root).  Writes one line per leaf, in input order of the trees
+  and preorder of the leaves: the index of the tree, the label and the cluster number, clusters being numbered
+  from 0 in each tree by their first leaf.  Cluster roots are found with a LevelAncestorIndex in O(log n) per
+  leaf, and trees are processed by -p threads (default: all cores).
+**/
+void exec_cluster(map<string, string>& args) {
+	if (!args.count("i") || (!args.count("t") && !args.count("k"))) {
+		cout << "Please specify an input filename with -i [filename], and a distance with -t [threshold] or a depth with -k [depth]" << endl;
+		return;
+	}
+
+	bool by_depth = args.count("k");
+	double threshold = (by_depth ? 0.0 : Util::ToDouble(args["t"]));
+	int depth = (by_depth ? Util::ToInt(args["k"]) : 0);
+	int nbthreads = max(1, (int)thread::hardware_concurrency());
+	if (args.count("p"))
+		nbthreads = max(1, Util::ToInt(args["p"]));
+
+	vector<vector<pair<long long, string>>> thread_lines(nbthreads);
+	ifstream in(args["i"]);
+	ParallelTreeReader::for_each_tree(in, nbthreads, [&](Node* tree, int t, long long i) {
+		LevelAncestorIndex index(tree);
+		unordered_map<int, int> clusters;
+		string lines = "";
+		for (int id = 0; id < index.get_nb_nodes(); ++id) {
+			if (!index.get_node(id)->is_leaf())
+				continue;
+			int a = (by_depth ? index.get_level_ancestor(id, depth) : index.get_highest_ancestor_at_distance(id, threshold));
+			if (a == -1)
+				a = id;
+			if (!clusters.count(a)) {
+				int c = clusters.size();
+				clusters[a] = c;
+			}
+			int c = clusters[a];
+			lines += Util::ToString((int)i) + "\t" + index.get_node(id)->label + "\t" + Util::ToString(c) + "\n";
+		}
+		thread_lines[t].push_back(make_pair(i, lines));
+	});
+
+	vector<pair<long long, string>> lines;
+	for (auto& tl : thread_lines)
+		lines.insert(lines.end(), tl.begin(), tl.end());
+	sort(lines.begin(), lines.end());
+
+	ofstream outfile_stream;
+	if (args.count("o"))
+		outfile_stream.open(args["o"]);
+	ostream& out = (args.count("o") ? outfile_stream : cout);
+	for (auto& l : lines)
+		out << l.second;
+	out.flush();
+}
+
+
+
+
+
+
+/**
+  Writes one line per tree of the -i file with the index of the tree, followed by its duplicated leaf labels
+  and their number of leaves (as label:count, tab separated, sorted by label), found with a LabelIndex.  With
+  -all, internal node labels are checked too.
+**/
+void exec_duplabels(map<string, string>& args) {
+	if (!args.count("i")) {
+		cout << "Please specify an input filename with -i [filename]" << endl;
+		return;
+	}
+
+	ofstream outfile_stream;
+	if (args.count("o"))
+		outfile_stream.open(args["o"]);
+	ostream& out = (args.count("o") ? outfile_stream : cout);
+
+	ifstream in(args["i"]);
+	Node* tree;
+	int index = 0;
+	while ((tree = NewickLex::ReadNextTree(in))) {
+		LabelIndex labels(tree, !args.count("all"));
+		vector<string> duplicated = labels.get_duplicated_labels();
+		sort(duplicated.begin(), duplicated.end());
+
+		out << index;
+		for (string& label : duplicated)
+			out << "\t" << label << ":" << labels.count(label);
+		out << "\n";
+
+		delete tree;
+		index++;
+	}
+	out.flush();
+}
+
+
+
+
+
+
+int main(int argc, char** argv) {
+
+	map<string, string> args = Util::ParseArguments(argc, argv);
+
+	/*
+	//just some tests
+	args["m"] = "rnd";
+	args["n"] = "10000";
+	//args["o"] = "C:\\Users\\Manuel\\Desktop\\tmp\\trees.txt";
+
+	args["m"] = "all_reroots";
+	//args["i"] = "C:\\Users\\Manuel\\Desktop\\tmp\\tree.txt";
+	args["i"] = "C:\\Users\\lafm2722\\Desktop\\tmp\\tree.txt";
+	*/
+
+	if (args.count("m") && args["m"] == "all_reroots") {
+		exec_all_reroots(args);
+	}
+
+	if (args.count("m") && args["m"] == "incompat") {
+		exec_incompat(args);
+	}
+
+	if (args.count("m") && args["m"] == "mwis") {
+		exec_mwis(args);
+	}
+
+	if (args.count("m") && args["m"] == "maxflow_check") {
+		exec_maxflow_check(args);
+	}
+
+
+
+	if (args.count("m") && args["m"] == "rnd") {
+		exec_rnd(args);
+	}
+
+	if (args.count("m") && args["m"] == "perturb") {
+		exec_perturb(args);
+	}
+
+	if (args.count("m") && args["m"] == "rf") {
+		exec_rf(args);
+	}
+
+	if (args.count("m") && args["m"] == "rfmatrix") {
+		exec_rfmatrix(args);
+	}
+
+	if (args.count("m") && args["m"] == "consensus") {
+		exec_consensus(args);
+	}
+
+	if (args.count("m") && args["m"] == "support") {
+		exec_support(args);
+	}
+
+	if (args.count("m") && args["m"] == "reconcile") {
+		exec_reconcile(args);
+	}
+
+	if (args.count("m") && args["m"] == "dlroot") {
+		exec_dlroot(args);
+	}
+
+	if (args.count("m") && args["m"] == "reroot_stats") {
+		exec_reroot_stats(args);
+	}
+
+	if (args.count("m") && args["m"] == "root") {
+		exec_root(args);
+	}
+
+	if (args.count("m") && args["m"] == "dedup") {
+		exec_dedup(args);
+	}
+
+	if (args.count("m") && args["m"] == "restrict") {
+		exec_restrict(args);
+	}
+
+	if (args.count("m") && args["m"] == "patristic") {
+		exec_patristic(args);
+	}
+
+	if (args.count("m") && args["m"] == "pathquery") {
+		exec_pathquery(args);
+	}
+
+	if (args.count("m") && args["m"] == "cluster") {
+		exec_cluster(args);
+	}
+
+	if (args.count("m") && args["m"] == "duplabels") {
+		exec_duplabels(args);
+	}
+	
+
+	return 0;
+}
+
+
+
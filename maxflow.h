@@ -1,149 +1,763 @@
-﻿//Push-Relabel Algorithm for Flows, Complexity: O(V^2 √E)
-//To obtain the actual flow values, look at all edges with capacity > 0
-//Zero capacity edges are residual edges
-
-//taken from: https://github.com/Ashishgup1/Competitive-Coding/blob/master/MaxFlow%20-%20Push%20Relabel%20%5BV%5E2%20sqrt(E)%5D.cpp
-
-
-#include <vector>
-#include <queue>
-
-using namespace std;
-
-struct edge
-{
-	int from, to, cap, flow, index;
-	edge(int from, int to, int cap, int flow, int index) :
-		from(from), to(to), cap(cap), flow(flow), index(index) {}
-};
-
-struct PushRelabel
-{
-	static const long long INF = 1e18;
-
-	int n;
-	vector<vector<edge> > g;
-	vector<long long> excess;
-	vector<int> height;
-
-	int source, sink;
-
-	PushRelabel(int n) :
-		n(n), g(n), excess(n), height(n) {}
-
-	void addEdge(int from, int to, int cap)
-	{
-		g[from].push_back(edge(from, to, cap, 0, g[to].size()));
-		if (from == to)
-			g[from].back().index++;
-		g[to].push_back(edge(to, from, 0, 0, g[from].size() - 1));
-	}
-
-
-	vector<int> getReachableBySource() {
-		queue<int> queue;
-		vector<bool> visited(n, false);
-		vector<int> ret;
-
-		queue.push(source);
-		visited[source] = true;
-
-		while (!queue.empty()) {
-			int v = queue.front();
-			queue.pop();
-
-			//todo
-		}
-
-
-	}
-
-
-
-
-
-	void push(edge& e)
-	{
-		int amt = (int)min(excess[e.from], (long long)e.cap - e.flow);
-		if (height[e.from] <= height[e.to] || amt == 0)
-			return;
-		e.flow += amt;
-		g[e.to][e.index].flow -= amt;
-		excess[e.to] += amt;
-		excess[e.from] -= amt;
-	}
-
-	void relabel(int u)
-	{
-		int d = 2e5;
-		for (auto& it : g[u])
-		{
-			if (it.cap - it.flow > 0)
-				d = min(d, height[it.to]);
-		}
-		if (d < INF)
-			height[u] = d + 1;
-	}
-
-	vector<int> find_max_height_vertices(int source, int dest)
-	{
-		vector<int> max_height;
-		for (int i = 0; i < n; i++)
-		{
-			if (i != source && i != dest && excess[i] > 0)
-			{
-				if (!max_height.empty() && height[i] > height[max_height[0]])
-					max_height.clear();
-				if (max_height.empty() || height[i] == height[max_height[0]])
-					max_height.push_back(i);
-			}
-		}
-		return max_height;
-	}
-
-	long long max_flow(int source, int dest)
-	{
-		this->source = source;
-		this->sink = dest;
-
-		excess.assign(n, 0);
-		height.assign(n, 0);
-		height[source] = n;
-		excess[source] = INF;
-		for (auto& it : g[source])
-			push(it);
-
-		vector<int> current;
-		while (!(current = find_max_height_vertices(source, dest)).empty())
-		{
-			for (auto i : current)
-			{
-				bool pushed = false;
-				for (auto& e : g[i])
-				{
-					if (excess[i] == 0)
-						break;
-					if (e.cap - e.flow > 0 && height[e.from] == height[e.to] + 1)
-					{
-						push(e);
-						pushed = true;
-					}
-				}
-				if (!pushed)
-				{
-					relabel(i);
-					break;
-				}
-			}
-		}
-
-		long long max_flow = 0;
-		for (auto& e : g[source])
-			max_flow += e.flow;
-
-		return max_flow;
-	}
-};
-
-//Problem 1: http://codeforces.com/contest/546/problem/E
-//Solution 1: http://codeforces.com/contest/546/submission/40528334
\ No newline at end of file
+﻿#pragma once
+
+//SimplePushRelabel is the original implementation, kept as a reference to validate PushRelabel below.
+//Push-Relabel Algorithm for Flows, Complexity: O(V^2 √E)
+//To obtain the actual flow values, look at all edges with capacity > 0
+//Zero capacity edges are residual edges
+
+//taken from: https://github.com/Ashishgup1/Competitive-Coding/blob/master/MaxFlow%20-%20Push%20Relabel%20%5BV%5E2%20sqrt(E)%5D.cpp
+
+
+#include <vector>
+#include <queue>
+#include <string>
+
+using namespace std;
+
+struct edge
+{
+	int from, to;
+	long long cap, flow;
+	int index;
+	edge(int from, int to, long long cap, long long flow, int index) :
+		from(from), to(to), cap(cap), flow(flow), index(index) {}
+};
+
+struct SimplePushRelabel
+{
+	static const long long INF = 1e18;
+
+	int n;
+	vector<vector<edge> > g;
+	vector<long long> excess;
+	vector<int> height;
+
+	int source, sink;
+
+	SimplePushRelabel(int n) :
+		n(n), g(n), excess(n), height(n) {}
+
+	void addEdge(int from, int to, long long cap)
+	{
+		g[from].push_back(edge(from, to, cap, 0, g[to].size()));
+		if (from == to)
+			g[from].back().index++;
+		g[to].push_back(edge(to, from, 0, 0, g[from].size() - 1));
+	}
+
+
+	/**
+	  Returns the vertices reachable from the source in the residual graph, i.e. the source side of a minimum cut.
+	  Must be called after max_flow.
+	  **/
+	vector<int> getReachableBySource() {
+		queue<int> queue;
+		vector<bool> visited(n, false);
+		vector<int> ret;
+
+		queue.push(source);
+		visited[source] = true;
+
+		while (!queue.empty()) {
+			int v = queue.front();
+			queue.pop();
+			ret.push_back(v);
+
+			for (auto& e : g[v])
+			{
+				if (!visited[e.to] && e.cap - e.flow > 0)
+				{
+					visited[e.to] = true;
+					queue.push(e.to);
+				}
+			}
+		}
+
+		return ret;
+	}
+
+
+
+
+
+	void push(edge& e)
+	{
+		long long amt = min(excess[e.from], e.cap - e.flow);
+		if (height[e.from] <= height[e.to] || amt == 0)
+			return;
+		e.flow += amt;
+		g[e.to][e.index].flow -= amt;
+		excess[e.to] += amt;
+		excess[e.from] -= amt;
+	}
+
+	void relabel(int u)
+	{
+		int d = 2e5;
+		for (auto& it : g[u])
+		{
+			if (it.cap - it.flow > 0)
+				d = min(d, height[it.to]);
+		}
+		if (d < INF)
+			height[u] = d + 1;
+	}
+
+	vector<int> find_max_height_vertices(int source, int dest)
+	{
+		vector<int> max_height;
+		for (int i = 0; i < n; i++)
+		{
+			if (i != source && i != dest && excess[i] > 0)
+			{
+				if (!max_height.empty() && height[i] > height[max_height[0]])
+					max_height.clear();
+				if (max_height.empty() || height[i] == height[max_height[0]])
+					max_height.push_back(i);
+			}
+		}
+		return max_height;
+	}
+
+	long long max_flow(int source, int dest)
+	{
+		this->source = source;
+		this->sink = dest;
+
+		excess.assign(n, 0);
+		height.assign(n, 0);
+		height[source] = n;
+		excess[source] = INF;
+		for (auto& it : g[source])
+			push(it);
+
+		vector<int> current;
+		while (!(current = find_max_height_vertices(source, dest)).empty())
+		{
+			for (auto i : current)
+			{
+				bool pushed = false;
+				for (auto& e : g[i])
+				{
+					if (excess[i] == 0)
+						break;
+					if (e.cap - e.flow > 0 && height[e.from] == height[e.to] + 1)
+					{
+						push(e);
+						pushed = true;
+					}
+				}
+				if (!pushed)
+				{
+					relabel(i);
+					break;
+				}
+			}
+		}
+
+		long long max_flow = 0;
+		for (auto& e : g[source])
+			max_flow += e.flow;
+
+		return max_flow;
+	}
+};
+
+//Problem 1: http://codeforces.com/contest/546/problem/E
+//Solution 1: http://codeforces.com/contest/546/submission/40528334
+
+
+
+
+
+
+/**
+  Common interface of the max-flow engines.  Edges are collected by addEdge, then each engine works on the CSR
+  arrays of arcs built by build_arcs (each edge has a forward arc and a reverse arc, rescap holds the residual capacities).
+  **/
+struct MaxFlowSolver
+{
+	int n;
+	int source, sink;
+
+	//edges, as added
+	vector<int> edge_from, edge_to;
+	vector<long long> edge_cap;
+
+	//CSR arcs: the arcs of v are first_arc[v]..first_arc[v + 1] - 1, arc_of_edge[e] is the forward arc of edge e
+	vector<int> first_arc, head, rev, arc_of_edge, edge_of_arc;
+	vector<long long> rescap;
+	bool built;
+
+
+	MaxFlowSolver(int n) :
+		n(n), source(0), sink(0), built(false) {}
+
+	virtual ~MaxFlowSolver() {}
+
+
+	virtual string get_name() = 0;
+
+	/**
+	  Returns the value of a maximum flow from source to dest.
+	  **/
+	virtual long long max_flow(int source, int dest) = 0;
+
+
+	/**
+	  Adds an edge and returns its id.
+	  **/
+	int addEdge(int from, int to, long long cap)
+	{
+		edge_from.push_back(from);
+		edge_to.push_back(to);
+		edge_cap.push_back(cap);
+		built = false;
+		return edge_from.size() - 1;
+	}
+
+	int get_nb_edges()
+	{
+		return edge_from.size();
+	}
+
+	/**
+	  Flow sent through edge e by the last max_flow call.
+	  **/
+	long long get_flow(int e)
+	{
+		return edge_cap[e] - rescap[arc_of_edge[e]];
+	}
+
+
+
+	void build_arcs()
+	{
+		int m = edge_from.size();
+		first_arc.assign(n + 1, 0);
+		for (int e = 0; e < m; ++e)
+		{
+			first_arc[edge_from[e] + 1]++;
+			first_arc[edge_to[e] + 1]++;
+		}
+		for (int v = 0; v < n; ++v)
+			first_arc[v + 1] += first_arc[v];
+
+		vector<int> pos(first_arc.begin(), first_arc.end() - 1);
+		head.resize(2 * m);
+		rev.resize(2 * m);
+		edge_of_arc.resize(2 * m);
+		arc_of_edge.resize(m);
+		for (int e = 0; e < m; ++e)
+		{
+			int a = pos[edge_from[e]]++;
+			int b = pos[edge_to[e]]++;
+			head[a] = edge_to[e];
+			head[b] = edge_from[e];
+			rev[a] = b;
+			rev[b] = a;
+			edge_of_arc[a] = edge_of_arc[b] = e;
+			arc_of_edge[e] = a;
+		}
+
+		built = true;
+	}
+
+
+
+	/**
+	  Flow leaving the tail of arc a through it (negative on the reverse arc of an edge carrying flow).
+	  **/
+	long long get_arc_flow(int a)
+	{
+		int e = edge_of_arc[a];
+		if (arc_of_edge[e] == a)
+			return edge_cap[e] - rescap[a];
+		return -(edge_cap[e] - rescap[rev[a]]);
+	}
+
+
+
+	/**
+	  Builds the arcs if needed and sets the residual capacities to the capacities (zero flow).
+	  **/
+	void reset_residual()
+	{
+		if (!built)
+			build_arcs();
+
+		rescap.resize(head.size());
+		for (size_t e = 0; e < edge_cap.size(); ++e)
+		{
+			rescap[arc_of_edge[e]] = edge_cap[e];
+			rescap[rev[arc_of_edge[e]]] = 0;
+		}
+	}
+
+
+
+	/**
+	  Returns the source side of a minimum cut.  Must be called after max_flow.
+	  This default version returns the vertices reachable from the source in the residual graph, which is
+	  correct for engines that end with a proper flow.
+	  **/
+	virtual vector<int> getReachableBySource()
+	{
+		vector<bool> visited(n, false);
+		vector<int> ret;
+		ret.push_back(source);
+		visited[source] = true;
+		for (size_t q = 0; q < ret.size(); ++q)
+		{
+			int u = ret[q];
+			for (int a = first_arc[u]; a < first_arc[u + 1]; ++a)
+			{
+				if (!visited[head[a]] && rescap[a] > 0)
+				{
+					visited[head[a]] = true;
+					ret.push_back(head[a]);
+				}
+			}
+		}
+		return ret;
+	}
+
+
+
+	/**
+	  Approximate number of bytes used by the solver.  Engines add their own arrays.
+	  **/
+	virtual size_t get_memory_usage()
+	{
+		return (edge_from.capacity() + edge_to.capacity() + first_arc.capacity() + head.capacity() +
+			rev.capacity() + arc_of_edge.capacity() + edge_of_arc.capacity()) * sizeof(int) +
+			(edge_cap.capacity() + rescap.capacity()) * sizeof(long long);
+	}
+};
+
+
+
+
+
+
+/**
+  Highest-label push-relabel (Goldberg-Tarjan with the heuristics of Cherkassky-Goldberg), computing a maximum preflow.
+  - edges are stored in CSR arrays of arcs (each edge has a forward arc and a reverse arc), built on the first max_flow call.
+  - active vertices are kept in buckets by height, and the highest one is always discharged first.
+  - gap heuristic: when no vertex is left at some height h < n, every vertex above h is cut from the sink and lifted to n.
+  - global relabeling: heights are periodically reset to exact distances to the sink by a reverse BFS.
+  Only vertices of height < n are processed, so the excess that cannot reach the sink stays where it is.  This is
+  enough for the value of the max flow and for a minimum cut, but the per-edge values are those of a preflow.
+  **/
+struct PushRelabel : public MaxFlowSolver
+{
+	static const long long INF = 1e18;
+
+	vector<long long> excess;
+	vector<int> height;
+	vector<int> cur_arc;
+
+	//buckets: active vertices of each height (stack), and all vertices of each height (doubly linked, for the gaps)
+	vector<int> active_first, active_next;
+	vector<int> all_first, all_next, all_prev;
+	int max_active, max_height;
+
+	long long work_since_update;
+	long long nb_pushes, nb_relabels, nb_global_updates;
+
+	bool solved;	//true once max_flow was called, the preflow is then kept for reoptimize
+
+
+	PushRelabel(int n) :
+		MaxFlowSolver(n), excess(n), height(n), solved(false) {}
+
+
+	string get_name()
+	{
+		return "pushrelabel";
+	}
+
+
+
+	void add_active(int v)
+	{
+		int h = height[v];
+		active_next[v] = active_first[h];
+		active_first[h] = v;
+		if (h > max_active)
+			max_active = h;
+	}
+
+	void add_to_bucket(int v)
+	{
+		int h = height[v];
+		all_prev[v] = -1;
+		all_next[v] = all_first[h];
+		if (all_first[h] != -1)
+			all_prev[all_first[h]] = v;
+		all_first[h] = v;
+		if (h > max_height)
+			max_height = h;
+	}
+
+	void remove_from_bucket(int v)
+	{
+		if (all_prev[v] != -1)
+			all_next[all_prev[v]] = all_next[v];
+		else
+			all_first[height[v]] = all_next[v];
+		if (all_next[v] != -1)
+			all_prev[all_next[v]] = all_prev[v];
+	}
+
+
+
+	/**
+	  Sets every height to the exact residual distance to the sink (n if the sink cannot be reached), then rebuilds the buckets.
+	  **/
+	void global_relabel()
+	{
+		nb_global_updates++;
+		work_since_update = 0;
+
+		height.assign(n, n);
+		height[sink] = 0;
+
+		vector<int> queue;
+		queue.reserve(n);
+		queue.push_back(sink);
+		for (size_t q = 0; q < queue.size(); ++q)
+		{
+			int u = queue[q];
+			for (int a = first_arc[u]; a < first_arc[u + 1]; ++a)
+			{
+				int w = head[a];
+				if (height[w] == n && w != source && rescap[rev[a]] > 0)
+				{
+					height[w] = height[u] + 1;
+					queue.push_back(w);
+				}
+			}
+		}
+
+		active_first.assign(n, -1);
+		all_first.assign(n, -1);
+		max_active = -1;
+		max_height = -1;
+		for (int v = 0; v < n; ++v)
+		{
+			cur_arc[v] = first_arc[v];
+			if (v == source || v == sink || height[v] >= n)
+				continue;
+			add_to_bucket(v);
+			if (excess[v] > 0)
+				add_active(v);
+		}
+	}
+
+
+
+	/**
+	  No vertex is left at height h: all vertices above are disconnected from the sink.
+	  **/
+	void gap(int h)
+	{
+		for (int g = h + 1; g <= max_height; ++g)
+		{
+			for (int v = all_first[g]; v != -1; v = all_next[v])
+				height[v] = n;
+			all_first[g] = -1;
+		}
+		max_height = h - 1;
+	}
+
+
+
+	void push(int v, int a)
+	{
+		int w = head[a];
+		long long amt = min(excess[v], rescap[a]);
+		if (excess[w] == 0 && w != sink && w != source)
+			add_active(w);
+		rescap[a] -= amt;
+		rescap[rev[a]] += amt;
+		excess[v] -= amt;
+		excess[w] += amt;
+		nb_pushes++;
+	}
+
+
+
+	void discharge(int v)
+	{
+		while (true)
+		{
+			int h = height[v];
+			int end = first_arc[v + 1];
+			for (int a = cur_arc[v]; a < end; ++a)
+			{
+				if (rescap[a] > 0 && height[head[a]] == h - 1)
+				{
+					push(v, a);
+					if (excess[v] == 0)
+					{
+						cur_arc[v] = a;
+						return;
+					}
+				}
+			}
+
+			//relabel
+			nb_relabels++;
+			work_since_update += 12 + (end - first_arc[v]);
+			int newh = n;
+			int newarc = first_arc[v];
+			for (int a = first_arc[v]; a < end; ++a)
+			{
+				if (rescap[a] > 0 && height[head[a]] + 1 < newh)
+				{
+					newh = height[head[a]] + 1;
+					newarc = a;
+				}
+			}
+
+			remove_from_bucket(v);
+			if (all_first[h] == -1)
+			{
+				gap(h);
+				height[v] = n;
+				return;
+			}
+			height[v] = newh;
+			if (newh >= n)
+				return;
+			cur_arc[v] = newarc;
+			add_to_bucket(v);
+		}
+	}
+
+
+
+	long long max_flow(int source, int dest)
+	{
+		this->source = source;
+		this->sink = dest;
+
+		reset_residual();
+
+		excess.assign(n, 0);
+		cur_arc.assign(n, 0);
+		active_next.assign(n, -1);
+		all_next.assign(n, -1);
+		all_prev.assign(n, -1);
+		nb_pushes = nb_relabels = nb_global_updates = 0;
+
+		if (source == dest)
+			return 0;
+
+		saturate_source();
+		run();
+		solved = true;
+
+		return excess[sink];
+	}
+
+
+
+	/**
+	  Saturates every residual arc leaving the source, as required by its height of n.
+	  **/
+	void saturate_source()
+	{
+		for (int a = first_arc[source]; a < first_arc[source + 1]; ++a)
+		{
+			if (rescap[a] == 0 || head[a] == source)
+				continue;
+			long long amt = rescap[a];
+			rescap[a] = 0;
+			rescap[rev[a]] += amt;
+			excess[head[a]] += amt;
+			excess[source] -= amt;
+		}
+	}
+
+
+
+	/**
+	  Changes the capacity of edge e.  Once max_flow was called, the current preflow is kept: if the new capacity is
+	  below the flow on e, that flow is cut down, leaving an excess at the tail and a deficit at the head of e,
+	  both handled by the next reoptimize call.
+	  **/
+	void set_capacity(int e, long long cap)
+	{
+		if (!solved || e >= (int)arc_of_edge.size())
+		{
+			edge_cap[e] = cap;
+			return;
+		}
+
+		long long f = get_flow(e);
+		int a = arc_of_edge[e];
+		edge_cap[e] = cap;
+		if (cap >= f)
+		{
+			rescap[a] = cap - f;
+		}
+		else
+		{
+			rescap[a] = 0;
+			rescap[rev[a]] = cap;
+			excess[edge_from[e]] += f - cap;
+			excess[edge_to[e]] -= f - cap;
+		}
+	}
+
+
+
+	/**
+	  Returns the value of a maximum flow after capacity changes (set_capacity) and edge insertions (addEdge), starting
+	  from the preflow of the previous call instead of from scratch:
+	  - new edges rebuild the CSR arrays, the flow of the existing edges is carried over.
+	  - deficits left by capacity decreases are pushed forward along the edges carrying flow, until they are absorbed
+	    by some excess or reach the sink, which only cancels flow.
+	  - the source arcs are saturated again, heights are recomputed by a global relabeling and the usual loop resumes.
+	  The work is proportional to the part of the flow that actually changes, plus one global relabeling.
+	  **/
+	long long reoptimize()
+	{
+		if (!solved)
+			return max_flow(source, sink);
+
+		if (!built)
+		{
+			vector<long long> flows(arc_of_edge.size());
+			for (size_t e = 0; e < flows.size(); ++e)
+				flows[e] = get_flow(e);
+
+			build_arcs();
+			rescap.assign(head.size(), 0);
+			for (size_t e = 0; e < edge_cap.size(); ++e)
+			{
+				long long f = (e < flows.size() ? flows[e] : 0);
+				rescap[arc_of_edge[e]] = edge_cap[e] - f;
+				rescap[rev[arc_of_edge[e]]] = f;
+			}
+		}
+
+		repair_deficits();
+		saturate_source();
+		run();
+
+		return excess[sink];
+	}
+
+
+
+	/**
+	  Cancels flow downstream of the vertices of negative excess.
+	  **/
+	void repair_deficits()
+	{
+		vector<int> stack;
+		for (int v = 0; v < n; ++v)
+		{
+			if (v != source && v != sink && excess[v] < 0)
+				stack.push_back(v);
+		}
+
+		while (!stack.empty())
+		{
+			int v = stack.back();
+			stack.pop_back();
+			for (int a = first_arc[v]; a < first_arc[v + 1] && excess[v] < 0; ++a)
+			{
+				long long f = get_arc_flow(a);
+				if (f <= 0)
+					continue;
+
+				long long amt = min(-excess[v], f);
+				int w = head[a];
+				rescap[a] += amt;
+				rescap[rev[a]] -= amt;
+				excess[v] += amt;
+
+				bool was_deficit = (excess[w] < 0);
+				excess[w] -= amt;
+				if (!was_deficit && excess[w] < 0 && w != source && w != sink)
+					stack.push_back(w);
+			}
+		}
+	}
+
+
+
+	/**
+	  Main loop, from the current preflow.
+	  **/
+	void run()
+	{
+		global_relabel();
+		long long global_freq = 12LL * n + head.size();
+
+		while (max_active >= 0)
+		{
+			int v = active_first[max_active];
+			if (v == -1)
+			{
+				max_active--;
+				continue;
+			}
+			active_first[max_active] = active_next[v];
+
+			discharge(v);
+
+			if (work_since_update > global_freq)
+				global_relabel();
+		}
+	}
+
+
+
+	/**
+	  Returns the source side of a minimum cut, i.e. the vertices that cannot reach the sink in the residual graph.
+	  The source reachable set is not a minimum cut here since the excess left in the preflow is not returned to the source.
+	  Must be called after max_flow.
+	  **/
+	vector<int> getReachableBySource()
+	{
+		vector<bool> reaches_sink(n, false);
+		vector<int> queue;
+		queue.push_back(sink);
+		reaches_sink[sink] = true;
+		for (size_t q = 0; q < queue.size(); ++q)
+		{
+			int u = queue[q];
+			for (int a = first_arc[u]; a < first_arc[u + 1]; ++a)
+			{
+				int w = head[a];
+				if (!reaches_sink[w] && rescap[rev[a]] > 0)
+				{
+					reaches_sink[w] = true;
+					queue.push_back(w);
+				}
+			}
+		}
+
+		vector<int> ret;
+		for (int v = 0; v < n; ++v)
+		{
+			if (!reaches_sink[v])
+				ret.push_back(v);
+		}
+		return ret;
+	}
+
+
+
+	size_t get_memory_usage()
+	{
+		return MaxFlowSolver::get_memory_usage() + excess.capacity() * sizeof(long long) +
+			(height.capacity() + cur_arc.capacity() + active_first.capacity() + active_next.capacity() +
+			all_first.capacity() + all_next.capacity() + all_prev.capacity()) * sizeof(int);
+	}
+};
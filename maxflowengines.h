@@ -0,0 +1,36 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "maxflow.h"
+#include "dinic.h"
+#include "bkmaxflow.h"
+
+using namespace std;
+
+
+/**
+  Creation of the max-flow engines by name, so that callers can let the user pick the one that suits their graphs.
+  **/
+class MaxFlowEngines {
+public:
+
+    static vector<string> get_names() {
+        return { "pushrelabel", "dinic", "bk" };
+    }
+
+
+    /**
+      Returns a new engine on n vertices, or nullptr if the name is unknown.  User has to delete returned value.
+      **/
+    static MaxFlowSolver* create(const string& name, int n) {
+        if (name == "pushrelabel")
+            return new PushRelabel(n);
+        if (name == "dinic")
+            return new Dinic(n);
+        if (name == "bk")
+            return new BoykovKolmogorov(n);
+        return nullptr;
+    }
+};
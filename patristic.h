@@ -0,0 +1,211 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <iostream>
+#include <thread>
+#include <cstdio>
+#include <cstdint>
+
+#include "node.h"
+#include "lcaindex.h"
+
+using namespace std;
+
+
+/**
+  Patristic distances (sums of branch lengths along paths) between the nodes of a fixed tree.  A query is
+  d(a) + d(b) - 2 d(lca(a, b)) with d the distance to the root, so it takes O(1) after an O(n log n) LCAIndex.
+  Leaves are numbered 0..k-1 in preorder, so that the leaves of each subtree form a contiguous range: a row of
+  the leaf distance matrix is filled by walking up from the leaf, each ancestor a giving the same
+  d(leaf) - 2 d(a) offset to the leaves it adds, in O(k + depth) sequential writes without any LCA query.
+  **/
+class PatristicDistances {
+public:
+    PatristicDistances(Node* root) : index(root) {
+        int n = index.get_nb_nodes();
+        distances.assign(n, 0.0);
+        first_leaf.assign(n, 0);
+        end_leaf.assign(n, 0);
+
+        //ids are in preorder
+        for (int id = 0; id < n; ++id) {
+            if (id > 0)
+                distances[id] = distances[index.get_parent(id)] + index.get_node(id)->branch_length;
+            first_leaf[id] = leaves.size();
+            if (index.get_node(id)->is_leaf()) {
+                leaves.push_back(id);
+                leaf_distances.push_back(distances[id]);
+            }
+            end_leaf[id] = leaves.size();
+        }
+        for (int id = n - 1; id > 0; --id) {
+            int p = index.get_parent(id);
+            end_leaf[p] = max(end_leaf[p], end_leaf[id]);
+        }
+    }
+
+
+    int get_nb_leaves() const {
+        return leaves.size();
+    }
+
+    /**
+      The i-th leaf in preorder, which is the i-th row and column of the matrices.
+      **/
+    Node* get_leaf(int i) const {
+        return index.get_node(leaves[i]);
+    }
+
+    const LCAIndex& get_index() const {
+        return index;
+    }
+
+
+
+    /**
+      Distance between the nodes with LCAIndex ids a and b.
+      **/
+    double get_distance(int a, int b) const {
+        return distances[a] + distances[b] - 2.0 * distances[index.get_lca(a, b)];
+    }
+
+
+    double get_distance(Node* a, Node* b) const {
+        return get_distance(index.get_id(a), index.get_id(b));
+    }
+
+
+    /**
+      Distance between the leaves with these labels, or -1 if one of them is not in the tree.
+      **/
+    double get_distance(const string& a, const string& b) const {
+        int ia = index.get_leaf_id(a);
+        int ib = index.get_leaf_id(b);
+        if (ia == -1 || ib == -1)
+            return -1.0;
+        return get_distance(ia, ib);
+    }
+
+
+
+    /**
+      Fills row[j] with the distance between the i-th and j-th leaves, for all j.
+      **/
+    template <class T>
+    void fill_row(int i, T* row) const {
+        int leaf = leaves[i];
+        double d = distances[leaf];
+        row[i] = 0;
+
+        int cur = leaf;
+        while (cur != 0) {
+            int p = index.get_parent(cur);
+            double offset = d - 2.0 * distances[p];
+            for (int j = first_leaf[p]; j < first_leaf[cur]; ++j)
+                row[j] = (T)(offset + leaf_distances[j]);
+            for (int j = end_leaf[cur]; j < end_leaf[p]; ++j)
+                row[j] = (T)(offset + leaf_distances[j]);
+            cur = p;
+        }
+    }
+
+
+
+    /**
+      Writes the leaf distance matrix, in the leaf order of get_leaf, as float or double values.  Formats:
+      - phylip: the number of leaves, then one line per leaf with its label and its row, separated by spaces
+      - binary: 8 bytes magic "TUDIST1", then the number of leaves and the size of a value (4 or 8) as uint64,
+        then the labels, one per line, then the rows in host byte order
+      Blocks of rows are filled and formatted by nbthreads threads and written in order, so memory stays bounded
+      for large trees.  Returns false if the stream fails.
+      **/
+    bool write_matrix(ostream& out, const string& format, bool use_float, int nbthreads) const {
+        if (use_float)
+            return write_matrix_values<float>(out, format == "binary", nbthreads);
+        return write_matrix_values<double>(out, format == "binary", nbthreads);
+    }
+
+
+
+private:
+    LCAIndex index;
+    vector<double> distances;           //to the root, by node id
+    vector<int> leaves;                 //node ids of the leaves in preorder
+    vector<double> leaf_distances;      //to the root, by leaf
+    vector<int> first_leaf, end_leaf;   //range of the leaves of each node
+
+
+
+    template <class T>
+    bool write_matrix_values(ostream& out, bool binary, int nbthreads) const {
+        nbthreads = max(1, nbthreads);
+        size_t k = leaves.size();
+
+        if (binary) {
+            char magic[8] = "TUDIST1";
+            uint64_t header[2] = { k, sizeof(T) };
+            out.write(magic, 8);
+            out.write((const char*)header, sizeof(header));
+            for (size_t i = 0; i < k; ++i)
+                out << get_leaf(i)->label << "\n";
+        }
+        else {
+            out << k << "\n";
+        }
+
+        //about 64MB of values per block
+        size_t block = max((size_t)nbthreads, ((size_t)1 << 23) / max(k, (size_t)1));
+        vector<string> texts(block);
+        vector<T> values;
+        if (binary)
+            values.resize(block * k);
+        else
+            values.resize(nbthreads * k);
+
+        for (size_t start = 0; start < k; start += block) {
+            size_t end = min(k, start + block);
+
+            auto work = [&](int t) {
+                char buffer[32];
+                for (size_t i = start + t; i < end; i += nbthreads) {
+                    T* row = (binary ? &values[(i - start) * k] : &values[t * k]);
+                    fill_row(i, row);
+                    if (binary)
+                        continue;
+
+                    string& text = texts[i - start];
+                    text = get_leaf(i)->label;
+                    for (size_t j = 0; j < k; ++j) {
+                        int len = snprintf(buffer, sizeof(buffer), (sizeof(T) == 4 ? " %.7g" : " %.15g"), (double)row[j]);
+                        text.append(buffer, len);
+                    }
+                    text += "\n";
+                }
+            };
+
+            vector<thread> threads;
+            for (int t = 1; t < nbthreads; ++t)
+                threads.push_back(thread(work, t));
+            work(0);
+            for (thread& th : threads)
+                th.join();
+
+            if (binary) {
+                out.write((const char*)values.data(), (end - start) * k * sizeof(T));
+            }
+            else {
+                for (size_t i = start; i < end; ++i) {
+                    out << texts[i - start];
+                    texts[i - start].clear();
+                    texts[i - start].shrink_to_fit();
+                }
+            }
+            if (!out)
+                return false;
+        }
+
+        return (bool)out;
+    }
+};
@@ -0,0 +1,228 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+
+#include "define.h"
+#include "rng.h"
+
+using namespace std;
+
+
+/**
+  Pseudo-random permutation of [0, n), in O(1) memory: a 4 rounds Feistel network on the smallest even number of
+  bits that covers n, with cycle walking to stay in range (less than 4 rounds trips per value in expectation).
+  **/
+class FeistelPermutation {
+private:
+    uint64 n;
+    int halfbits;
+    uint64 halfmask;
+    uint64 keys[4];
+
+public:
+    FeistelPermutation(uint64 n, Rng& rng) : n(n) {
+        int bits = 2;
+        while (bits < 64 && (1ULL << bits) < n)
+            bits++;
+        halfbits = (bits + 1) / 2;
+        halfmask = (1ULL << halfbits) - 1;
+        for (int r = 0; r < 4; ++r)
+            keys[r] = rng.next();
+    }
+
+
+    uint64 get(uint64 x) const {
+        do {
+            x = encrypt(x);
+        } while (x >= n);
+        return x;
+    }
+
+
+private:
+    uint64 encrypt(uint64 x) const {
+        uint64 left = x >> halfbits;
+        uint64 right = x & halfmask;
+        for (int r = 0; r < 4; ++r) {
+            uint64 z = right ^ keys[r];
+            uint64 f = Rng::splitmix64(z) & halfmask;
+            uint64 tmp = right;
+            right = left ^ f;
+            left = tmp;
+        }
+        return (left << halfbits) | right;
+    }
+};
+
+
+
+
+/**
+  Writes the newick of a random binary tree directly to a stream, without building Node objects.  The tree is
+  generated top-down: each internal node with k leaves draws the number of leaves of its left subtree from the
+  split distribution of the model, which gives the same distributions as the TreeUtil generators:
+  - split: Binomial(k, 1/2) conditioned on 1..k-1
+  - uniform, pda: P(1) = k / (2(2k - 3)), P(j + 1) / P(j) = (2j - 1)(k - j) / ((j + 1)(2k - 2j - 3)),
+    sampled from both ends since the distribution is symmetric and concentrated on small sides
+  - yule: uniform on 1..k-1
+  - caterpillar: 1, balanced: floor(k / 2)
+  Leaves are labelled 1..n from left to right for uniform, and by a FeistelPermutation of their positions otherwise.
+  Extra memory is O(height) ints, plus a fixed size output buffer.
+  **/
+class RandomNewickWriter {
+private:
+    string model;
+    Rng& rng;
+    ostream& out;
+    string buffer;
+
+    double min_length;
+    double max_length;
+
+    static constexpr long long CLOSE = -1;
+
+public:
+    RandomNewickWriter(const string& model, Rng& rng, ostream& out, double min_length = 1.0, double max_length = 10000.0)
+        : model(model), rng(rng), out(out), min_length(min_length), max_length(max_length) {}
+
+
+    static bool is_model(const string& model) {
+        return model == "split" || model == "uniform" || model == "pda" || model == "yule" ||
+               model == "caterpillar" || model == "balanced";
+    }
+
+
+
+    /**
+      Writes one tree on nb_leaves leaves followed by ";\n".  If unrooted, the root has three children (as rnd outputs).
+      Returns false, and writes nothing, if nb_leaves < 1.
+      **/
+    bool write_tree(long long nb_leaves, bool unrooted = true) {
+        if (nb_leaves < 1)
+            return false;
+
+        FeistelPermutation perm(nb_leaves, rng);
+        vector<long long> stack;
+        long long next_position = 0;
+        long long k = nb_leaves;
+
+        //root, as a trifurcation by splitting one of its internal children again
+        if (unrooted && nb_leaves >= 3) {
+            long long j = get_left_size(k);
+            long long a, b, c;
+            if (j >= 2) {
+                a = get_left_size(j);
+                b = j - a;
+                c = k - j;
+            }
+            else {
+                a = j;
+                b = get_left_size(k - j);
+                c = k - j - b;
+            }
+            buffer += '(';
+            stack.push_back(CLOSE);
+            stack.push_back(c);
+            stack.push_back(b);
+            k = a;
+        }
+
+        while (true) {
+            while (k > 1) {
+                long long j = get_left_size(k);
+                buffer += '(';
+                stack.push_back(CLOSE);
+                stack.push_back(k - j);
+                k = j;
+            }
+
+            long long label = (model == "uniform" ? next_position : (long long)perm.get(next_position)) + 1;
+            next_position++;
+            append_int(label);
+            if (!stack.empty())
+                append_length();
+
+            while (!stack.empty() && stack.back() == CLOSE) {
+                stack.pop_back();
+                buffer += ')';
+                if (!stack.empty())
+                    append_length();
+            }
+
+            if (stack.empty())
+                break;
+
+            k = stack.back();
+            stack.pop_back();
+            buffer += ',';
+
+            if (buffer.size() >= (1 << 16))
+                flush();
+        }
+
+        buffer += ";\n";
+        flush();
+        return true;
+    }
+
+
+
+    void flush() {
+        out.write(buffer.data(), buffer.size());
+        buffer.clear();
+    }
+
+
+
+    /**
+      Number of leaves of the left subtree of a node with k >= 2 leaves.
+      **/
+    long long get_left_size(long long k) {
+        if (model == "yule")
+            return 1 + rng.next_int(k - 1);
+        if (model == "caterpillar")
+            return 1;
+        if (model == "balanced")
+            return k / 2;
+        if (model == "split") {
+            long long j;
+            do {
+                j = (long long)rng.next_binomial(k, 0.5);
+            } while (j == 0 || j == k);
+            return j;
+        }
+
+        //uniform and pda: walk P(j) + P(k - j) for the smaller side j, then pick the side
+        double u = rng.next_double();
+        double p = (double)k / (2.0 * (2 * k - 3));
+        long long j = 1;
+        while (true) {
+            double pside = (2 * j == k ? p : 2 * p);
+            if (u < pside || 2 * j + 2 > k)
+                break;
+            u -= pside;
+            p *= (double)(2 * j - 1) * (k - j) / ((double)(j + 1) * (2 * k - 2 * j - 3));
+            j++;
+        }
+        return (2 * j == k || (rng.next() >> 63)) ? j : k - j;
+    }
+
+
+
+private:
+    void append_int(long long v) {
+        char buf[24];
+        int len = snprintf(buf, sizeof(buf), "%lld", v);
+        buffer.append(buf, len);
+    }
+
+    void append_length() {
+        char buf[32];
+        int len = snprintf(buf, sizeof(buf), ":%g", min_length + rng.next_double() * (max_length - min_length));
+        buffer.append(buf, len);
+    }
+};
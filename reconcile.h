@@ -0,0 +1,263 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <regex>
+
+#include "node.h"
+#include "allrootings.h"
+#include "lcaindex.h"
+
+using namespace std;
+
+
+/**
+  Extracts the species of a gene leaf from its label.  With an empty pattern the whole label is the species,
+  otherwise it is the first match of the regular expression pattern in the label, or its first capture group
+  if it has one (e.g. "spec[0-9]+" maps fam1gene8spec7 to spec7, and "_([^_]+)$" maps a_b_c to c).
+  **/
+class SpeciesExtractor {
+public:
+    SpeciesExtractor(const string& pattern = "") : pattern(pattern) {
+        if (pattern != "")
+            re = regex(pattern);
+    }
+
+
+    /**
+      Returns false if the pattern does not match the label.
+      **/
+    bool get_species(const string& label, string& species) const {
+        if (pattern == "") {
+            species = label;
+            return true;
+        }
+
+        smatch m;
+        if (!regex_search(label, m, re))
+            return false;
+        species = (m.size() > 1 ? m[1].str() : m[0].str());
+        return true;
+    }
+
+
+private:
+    string pattern;
+    regex re;
+};
+
+
+
+
+/**
+  LCA reconciliation of gene trees with a species tree.  Each gene node is mapped to the LCA of the species of its
+  leaves, computed bottom-up with one LCAIndex query per child, so a gene tree of size n costs O(n).  A gene node
+  is a duplication if it has the same mapping as one of its children, and the edge from g to its child c accounts
+  for depth(M(c)) - depth(M(g)) - 1 losses, plus one if g is a duplication (exact for binary trees, where this
+  gives the most parsimonious scenario).  Nodes with one child are ignored.
+  The index and extractor are only read, so one reconciler can be shared by threads.
+  **/
+class Reconciler {
+public:
+    struct Result {
+        int nb_duplications = 0;
+        int nb_losses = 0;
+    };
+
+    const LCAIndex& species_index;
+    const SpeciesExtractor& extractor;
+
+    Reconciler(const LCAIndex& species_index, const SpeciesExtractor& extractor)
+        : species_index(species_index), extractor(extractor) {}
+
+
+
+    /**
+      Species tree node id of each gene node (in the postorder of gene_tree), or an empty vector if the species of
+      a leaf cannot be found.
+      **/
+    vector<int> get_mapping(Node* gene_tree) const {
+        vector<Node*> nodes = gene_tree->get_postordered_nodes();
+        unordered_map<Node*, int> index;
+        return get_mapping(nodes, index);
+    }
+
+
+
+    /**
+      Counts the duplications and losses of gene_tree.  Returns false if the species of a leaf cannot be found.
+      **/
+    bool reconcile(Node* gene_tree, Result& result) const {
+        vector<Node*> nodes = gene_tree->get_postordered_nodes();
+        unordered_map<Node*, int> index;
+        vector<int> mapping = get_mapping(nodes, index);
+        if (mapping.empty())
+            return false;
+
+        result = Result();
+        for (size_t i = 0; i < nodes.size(); ++i) {
+            Node* g = nodes[i];
+            if (g->get_nb_children() < 2)
+                continue;
+
+            bool dup = false;
+            for (int k = 0; k < g->get_nb_children(); ++k)
+                dup = dup || mapping[index[g->get_child(k)]] == mapping[i];
+            if (dup)
+                result.nb_duplications++;
+
+            for (int k = 0; k < g->get_nb_children(); ++k) {
+                int mc = mapping[index[g->get_child(k)]];
+                result.nb_losses += species_index.get_depth(mc) - species_index.get_depth(mapping[i]) - 1 + (dup ? 1 : 0);
+            }
+        }
+
+        return true;
+    }
+
+
+
+
+    /**
+      Statistic of AllRootings for the duplications and losses of a rooted gene tree.  Subtrees are summarized by
+      their mapping and costs, and children sets by the LCA of their mappings, whether some child maps to it, and
+      the sums of their depths and costs, which are all associative.  missing is set if a leaf has no species.
+      **/
+    class DLStat {
+    public:
+        //mapping and costs of a rooted subtree
+        struct Value {
+            int mapping = -1;
+            long long nb_duplications = 0;
+            long long nb_losses = 0;
+        };
+
+        struct Set {
+            int lca = -1;
+            bool has_lca_child = false;
+            int nb_children = 0;
+            long long depth_sum = 0;
+            long long nb_duplications = 0;
+            long long nb_losses = 0;
+            Value single;               //the child, if there is only one
+        };
+
+        const Reconciler& reconciler;
+        bool missing = false;
+
+        DLStat(const Reconciler& reconciler) : reconciler(reconciler) {}
+
+
+        Value leaf(Node* v) {
+            Value t;
+            string species;
+            if (reconciler.extractor.get_species(v->label, species))
+                t.mapping = reconciler.species_index.get_leaf_id(species);
+            if (t.mapping == -1)
+                missing = true;
+            return t;
+        }
+
+
+        Set lift(const Value& t, double length) {
+            Set s;
+            if (t.mapping == -1)
+                return s;
+            s.lca = t.mapping;
+            s.has_lca_child = true;
+            s.nb_children = 1;
+            s.depth_sum = reconciler.species_index.get_depth(t.mapping);
+            s.nb_duplications = t.nb_duplications;
+            s.nb_losses = t.nb_losses;
+            s.single = t;
+            return s;
+        }
+
+
+        Set combine(const Set& a, const Set& b) {
+            if (a.nb_children == 0)
+                return b;
+            if (b.nb_children == 0)
+                return a;
+
+            Set s;
+            s.lca = reconciler.species_index.get_lca(a.lca, b.lca);
+            s.has_lca_child = (a.has_lca_child && a.lca == s.lca) || (b.has_lca_child && b.lca == s.lca);
+            s.nb_children = a.nb_children + b.nb_children;
+            s.depth_sum = a.depth_sum + b.depth_sum;
+            s.nb_duplications = a.nb_duplications + b.nb_duplications;
+            s.nb_losses = a.nb_losses + b.nb_losses;
+            return s;
+        }
+
+
+        /**
+          Same rules as reconcile: a single child is passed through.
+          **/
+        Value finalize(const Set& s, Node* v) {
+            if (s.nb_children == 0)
+                return Value();
+            if (s.nb_children == 1)
+                return s.single;
+
+            int dup = (s.has_lca_child ? 1 : 0);
+            long long losses = s.depth_sum - (long long)s.nb_children * (reconciler.species_index.get_depth(s.lca) + 1 - dup);
+            return { s.lca, s.nb_duplications + dup, s.nb_losses + losses };
+        }
+    };
+
+
+
+    /**
+      Duplications and losses of every rooting of gene_tree, seen as unrooted, in O(n) with AllRootings and DLStat:
+      entry i is for the rooting on the edge above the i-th node in postorder (the entry of the root is
+      meaningless), as listed by all_reroots.  Returns an empty vector if the species of a leaf cannot be found.
+      **/
+    vector<Result> reconcile_all_rootings(Node* gene_tree) const {
+        DLStat stat(*this);
+        vector<DLStat::Value> values = AllRootings<DLStat>::compute(gene_tree, stat);
+        if (stat.missing)
+            return vector<Result>();
+
+        vector<Result> results(values.size());
+        for (size_t i = 0; i < values.size(); ++i) {
+            results[i].nb_duplications = values[i].nb_duplications;
+            results[i].nb_losses = values[i].nb_losses;
+        }
+        return results;
+    }
+
+
+
+private:
+
+    /**
+      Mapping of the nodes, given in postorder, and fills index with the position of each node.
+      **/
+    vector<int> get_mapping(const vector<Node*>& nodes, unordered_map<Node*, int>& index) const {
+        vector<int> mapping(nodes.size(), -1);
+        string species;
+
+        for (size_t i = 0; i < nodes.size(); ++i) {
+            Node* g = nodes[i];
+            index[g] = i;
+            if (g->is_leaf()) {
+                if (!extractor.get_species(g->label, species))
+                    return vector<int>();
+                mapping[i] = species_index.get_leaf_id(species);
+                if (mapping[i] == -1)
+                    return vector<int>();
+            }
+            else {
+                int m = mapping[index[g->get_child(0)]];
+                for (int k = 1; k < g->get_nb_children(); ++k)
+                    m = species_index.get_lca(m, mapping[index[g->get_child(k)]]);
+                mapping[i] = m;
+            }
+        }
+
+        return mapping;
+    }
+};
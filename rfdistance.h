@@ -0,0 +1,333 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include <algorithm>
+
+#include "node.h"
+#include "rng.h"
+
+using namespace std;
+
+
+/**
+  Hashes the clades (rooted) or bipartitions (unrooted) of trees.  Each leaf label gets an id and a random 64 bits
+  key, shared by all the trees hashed with the same hasher, and a clade is hashed as the XOR of its leaf keys,
+  computed in one postorder pass.  A bipartition {A, B} is hashed as min(hash(A), hash(B)), where
+  hash(B) = hash(A) XOR hash(all leaves).  Distinct splits collide with probability about 2^-64 per pair.
+  Only the non-trivial splits are reported: clades of size 2..n-1, bipartitions with both sides of size >= 2.
+  Once frozen, the hasher does not learn new labels and can be shared by threads.
+  **/
+class BipartitionHasher {
+public:
+    unordered_map<string, int> label_to_leafid;
+    vector<string> leafid_to_label;
+    vector<uint64> leaf_keys;
+
+    //if true, unknown labels get id -1 and get_splits returns -1 on trees that have one
+    bool frozen = false;
+
+    BipartitionHasher(uint64 seed = 1) : rng(seed) {}
+
+
+    int get_leaf_id(const string& label) {
+        auto it = label_to_leafid.find(label);
+        if (it != label_to_leafid.end())
+            return it->second;
+        if (frozen)
+            return -1;
+
+        int id = leaf_keys.size();
+        label_to_leafid[label] = id;
+        leafid_to_label.push_back(label);
+        leaf_keys.push_back(rng.next());
+        return id;
+    }
+
+
+
+    /**
+      In an unrooted tree whose root has two children (once single-child nodes are skipped), the edges above the
+      two children are the same bipartition.  Returns the node, below the second child, whose split is skipped
+      for that reason, or nullptr.
+      **/
+    static Node* get_root_duplicate(Node* root) {
+        Node* r = root;
+        while (r->get_nb_children() == 1)
+            r = r->get_child(0);
+        if (r->get_nb_children() != 2)
+            return nullptr;
+
+        Node* dup = r->get_child(1);
+        while (dup->get_nb_children() == 1)
+            dup = dup->get_child(0);
+        return dup;
+    }
+
+
+
+    /**
+      Appends the split hashes of tree to hashes (one per non-trivial split, without duplicates),
+      and returns the number of leaves.  total is set to the XOR of all the leaf keys, which identifies the leaf set.
+      Nodes with a single child are skipped, since they have the same clade as their child.
+      If ranges is given, the clade of the node that gave each split is appended to it as (first, size), where
+      first is the position of its first leaf in the left-to-right leaf order of the tree, written to leaf_order
+      as leaf ids.
+      If the hasher is frozen and tree has an unknown label, returns -1 (hashes is left unchanged).
+      **/
+    int get_splits(Node* root, bool rooted, vector<uint64>& hashes, uint64& total,
+                   vector<pair<int, int>>* ranges = nullptr, vector<int>* leaf_order = nullptr) {
+        struct Frame {
+            Node* v;
+            int next;
+            uint64 h;
+            int size;
+            int first;
+        };
+
+        size_t first = hashes.size();
+        Node* root_duplicate = (rooted ? nullptr : get_root_duplicate(root));
+        vector<pair<int, int>> clades;
+        int nextpos = 0;
+        int n = 0;
+        vector<Frame> stack;
+        stack.push_back({ root, 0, 0, 0, -1 });
+
+        while (!stack.empty()) {
+            Frame& f = stack.back();
+            if (f.v->is_leaf()) {
+                int id = get_leaf_id(f.v->label);
+                if (id < 0) {
+                    hashes.resize(first);
+                    return -1;
+                }
+                f.h = leaf_keys[id];
+                f.size = 1;
+                f.first = nextpos++;
+                if (leaf_order)
+                    leaf_order->push_back(id);
+            }
+            else if (f.next < f.v->get_nb_children()) {
+                Node* c = f.v->get_child(f.next++);
+                stack.push_back({ c, 0, 0, 0, -1 });
+                continue;
+            }
+
+            Frame done = f;
+            stack.pop_back();
+
+            if (!stack.empty()) {
+                Frame& p = stack.back();
+                p.h ^= done.h;
+                p.size += done.size;
+                if (p.first == -1)
+                    p.first = done.first;
+
+                if (!done.v->is_leaf() && done.v->get_nb_children() != 1 && done.v != root_duplicate) {
+                    hashes.push_back(done.h);
+                    clades.push_back(make_pair(done.first, done.size));
+                }
+            }
+            else {
+                total = done.h;
+                n = done.size;
+            }
+        }
+
+        size_t k = first;
+        for (size_t i = first; i < hashes.size(); ++i) {
+            int size = clades[i - first].second;
+            uint64 h = hashes[i];
+            bool keep = (rooted ? size >= 2 && size <= n - 1 : size >= 2 && size <= n - 2);
+            if (keep) {
+                hashes[k++] = (rooted ? h : min(h, h ^ total));
+                if (ranges)
+                    ranges->push_back(clades[i - first]);
+            }
+        }
+        hashes.resize(k);
+
+        return n;
+    }
+
+
+private:
+    Rng rng;
+};
+
+
+
+
+/**
+  Robinson-Foulds distance: number of clades (rooted) or bipartitions (unrooted) that are in one tree but not
+  in the other.  Both trees must have the same leaf set, otherwise -1 is returned.
+  **/
+class RFDistance {
+public:
+
+    /**
+      O(n) expected, by comparing the split hashes of BipartitionHasher (see there for the collision probability).
+      With exact = true, uses get_rf_exact instead.
+      **/
+    static long long get_rf(Node* t1, Node* t2, bool rooted, bool exact = false) {
+        if (exact)
+            return get_rf_exact(t1, t2, rooted);
+
+        BipartitionHasher hasher;
+        vector<uint64> h1, h2;
+        uint64 total1 = 0, total2 = 0;
+        int n1 = hasher.get_splits(t1, rooted, h1, total1);
+        int n2 = hasher.get_splits(t2, rooted, h2, total2);
+        if (n1 != n2 || total1 != total2 || (int)hasher.leaf_keys.size() != n1)
+            return -1;
+
+        unordered_set<uint64> set1(h1.begin(), h1.end());
+        unordered_set<uint64> set2(h2.begin(), h2.end());
+        long long common = 0;
+        for (uint64 h : set2)
+            common += set1.count(h);
+
+        return (long long)set1.size() + (long long)set2.size() - 2 * common;
+    }
+
+
+
+    /**
+      Collision-free RF distance in O(n) expected, in the spirit of Day's algorithm.  Leaves are ranked in the
+      left-to-right order of t1, so that each clade of t1 is an interval of ranks, and each bipartition of t1 is an
+      interval once we take the side that does not contain the first leaf (the complement of an interval that
+      starts at rank 0 is an interval too).  A split of t2 with ranks in [min, max] is in t1 iff
+      max - min + 1 is its size and [min, max] is an interval of t1.  In t2, the side without the first leaf
+      is either a clade, or the complement of a clade, whose min and max come from prefix and suffix arrays.
+      **/
+    static long long get_rf_exact(Node* t1, Node* t2, bool rooted) {
+        unordered_map<string, int> rank;
+        for (Node* v : *t1) {
+            if (v->is_leaf()) {
+                int r = rank.size();
+                if (!rank.insert(make_pair(v->label, r)).second)
+                    return -1;
+            }
+        }
+        int n = rank.size();
+
+        vector<int> ranks1(n);
+        for (int i = 0; i < n; ++i)
+            ranks1[i] = i;
+        vector<pair<int, int>> sides1 = get_side_intervals(t1, ranks1, rooted);
+
+        vector<int> ranks2;
+        for (Node* v : *t2) {
+            if (v->is_leaf()) {
+                auto it = rank.find(v->label);
+                if (it == rank.end())
+                    return -1;
+                ranks2.push_back(it->second);
+            }
+        }
+        if ((int)ranks2.size() != n)
+            return -1;
+        vector<bool> seen(n, false);
+        for (int r : ranks2) {
+            if (seen[r])
+                return -1;
+            seen[r] = true;
+        }
+        vector<pair<int, int>> sides2 = get_side_intervals(t2, ranks2, rooted);
+
+        unordered_set<uint64> set1;
+        for (auto& s : sides1)
+            set1.insert((uint64)s.first * n + s.second);
+
+        long long common = 0;
+        for (auto& s : sides2) {
+            if (s.first >= 0 && set1.count((uint64)s.first * n + s.second))
+                common++;
+        }
+
+        return (long long)set1.size() + (long long)sides2.size() - 2 * common;
+    }
+
+
+
+private:
+
+    /**
+      For each non-trivial split of tree (same rules as BipartitionHasher::get_splits), the [min, max] of the
+      ranks of its side that does not contain the leaf of rank 0 (its clade if rooted), or (-1, -1) if these ranks
+      are not contiguous.  ranks gives the rank of each leaf of tree, in left-to-right order.
+      **/
+    static vector<pair<int, int>> get_side_intervals(Node* root, const vector<int>& ranks, bool rooted) {
+        int n = ranks.size();
+        vector<int> prefix_min(n + 1, n), prefix_max(n + 1, -1), suffix_min(n + 1, n), suffix_max(n + 1, -1);
+        for (int i = 0; i < n; ++i) {
+            prefix_min[i + 1] = min(prefix_min[i], ranks[i]);
+            prefix_max[i + 1] = max(prefix_max[i], ranks[i]);
+        }
+        for (int i = n - 1; i >= 0; --i) {
+            suffix_min[i] = min(suffix_min[i + 1], ranks[i]);
+            suffix_max[i] = max(suffix_max[i + 1], ranks[i]);
+        }
+
+        struct Frame {
+            Node* v;
+            int next;
+            int first, last;        //positions of the leaves of the clade, in left-to-right order
+            int minrank, maxrank;
+        };
+
+        Node* root_duplicate = (rooted ? nullptr : BipartitionHasher::get_root_duplicate(root));
+        vector<pair<int, int>> sides;
+        vector<Frame> stack;
+        stack.push_back({ root, 0, n, -1, n, -1 });
+        int nextpos = 0;
+
+        while (!stack.empty()) {
+            Frame& f = stack.back();
+            if (f.v->is_leaf()) {
+                f.first = f.last = nextpos;
+                f.minrank = f.maxrank = ranks[nextpos];
+                nextpos++;
+            }
+            else if (f.next < f.v->get_nb_children()) {
+                Node* c = f.v->get_child(f.next++);
+                stack.push_back({ c, 0, n, -1, n, -1 });
+                continue;
+            }
+
+            Frame done = f;
+            stack.pop_back();
+            if (stack.empty())
+                break;
+
+            Frame& p = stack.back();
+            p.first = min(p.first, done.first);
+            p.last = max(p.last, done.last);
+            p.minrank = min(p.minrank, done.minrank);
+            p.maxrank = max(p.maxrank, done.maxrank);
+
+            if (done.v->is_leaf() || done.v->get_nb_children() == 1 || done.v == root_duplicate)
+                continue;
+
+            int size = done.last - done.first + 1;
+            int lo = done.minrank, hi = done.maxrank;
+            if (!rooted && lo == 0) {
+                size = n - size;
+                lo = min(prefix_min[done.first], suffix_min[done.last + 1]);
+                hi = max(prefix_max[done.first], suffix_max[done.last + 1]);
+            }
+
+            if (size < 2 || size > (rooted ? n - 1 : n - 2))
+                continue;
+
+            if (hi - lo + 1 == size)
+                sides.push_back(make_pair(lo, hi));
+            else
+                sides.push_back(make_pair(-1, -1));
+        }
+
+        return sides;
+    }
+};
@@ -0,0 +1,251 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <cmath>
+
+#include "define.h"
+
+
+/**
+  Seedable 64 bits pseudo-random generator (xoshiro256**, Blackman and Vigna), with its state
+  initialized from the seed by splitmix64.  Fast, reproducible across platforms, and usable with the
+  <random> distributions since it satisfies UniformRandomBitGenerator.
+  **/
+class Rng
+{
+private:
+    uint64 s[4];
+
+    static uint64 rotl(uint64 x, int k) {
+        return (x << k) | (x >> (64 - k));
+    }
+
+public:
+    typedef uint64 result_type;
+
+    Rng(uint64 seed = 1) {
+        set_seed(seed);
+    }
+
+
+    /**
+      Advances x and returns the next splitmix64 output.  Also good as a standalone mixer of 64 bits values.
+      **/
+    static uint64 splitmix64(uint64& x) {
+        uint64 z = (x += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+
+    /**
+      Seed of the index-th independent stream derived from a master seed, e.g. one per generated tree, so that
+      results do not depend on how the work is split between threads.
+      **/
+    static uint64 derive_seed(uint64 seed, uint64 index) {
+        uint64 x = seed ^ (index * 0xD1B54A32D192ED03ULL);
+        splitmix64(x);
+        return splitmix64(x);
+    }
+
+
+    void set_seed(uint64 seed) {
+        uint64 x = seed;
+        for (int i = 0; i < 4; ++i)
+            s[i] = splitmix64(x);
+    }
+
+
+    uint64 next() {
+        uint64 result = rotl(s[1] * 5, 7) * 9;
+        uint64 t = s[1] << 17;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = rotl(s[3], 45);
+        return result;
+    }
+
+    uint64 operator()() {
+        return next();
+    }
+
+    static constexpr uint64 min() {
+        return 0;
+    }
+
+    static constexpr uint64 max() {
+        return ~0ULL;
+    }
+
+
+    /**
+      Uniform integer in [0, n), without modulo bias (Lemire's multiply-shift with rejection).  n must be > 0.
+      **/
+    uint64 next_int(uint64 n) {
+        __uint128_t m = (__uint128_t)next() * n;
+        uint64 low = (uint64)m;
+        if (low < n) {
+            uint64 threshold = (0 - n) % n;
+            while (low < threshold) {
+                m = (__uint128_t)next() * n;
+                low = (uint64)m;
+            }
+        }
+        return (uint64)(m >> 64);
+    }
+
+
+    /**
+      Uniform double in [0, 1), with 53 random bits.
+      **/
+    double next_double() {
+        return (next() >> 11) * 0x1.0p-53;
+    }
+
+
+
+    /**
+      Binomial(n, p) variate, drawn here rather than with std::binomial_distribution, whose output differs between
+      standard libraries.  Uses inversion (sequential search from 0) when the mean is below 10, in O(np) expected
+      time, and BTRD (Hormann 1993, transformed rejection with decomposition) otherwise, in O(1) expected time.
+      **/
+    uint64 next_binomial(uint64 n, double p) {
+        if (p <= 0.0 || n == 0)
+            return 0;
+        if (p >= 1.0)
+            return n;
+        if (p > 0.5)
+            return n - next_binomial(n, 1.0 - p);
+        if (n * p < 10.0)
+            return next_binomial_inversion(n, p);
+        return next_binomial_btrd(n, p);
+    }
+
+
+
+private:
+    uint64 next_binomial_inversion(uint64 n, double p) {
+        double q = 1.0 - p;
+        double s = p / q;
+        double a = (n + 1) * s;
+        double r0 = pow(q, (double)n);
+        while (true) {
+            double r = r0;
+            double u = next_double();
+            uint64 x = 0;
+            while (u > r && x < n) {
+                u -= r;
+                x++;
+                r *= a / x - s;
+            }
+            //u left over by rounding errors: draw again
+            if (u <= r)
+                return x;
+        }
+    }
+
+
+    /**
+      Stirling series remainder of log(k!), tabulated for small k.
+      **/
+    static double stirling_correction(uint64 k) {
+        static const double table[10] = {
+            0.08106146679532726, 0.04134069595540929, 0.02767792568499834, 0.02079067210376509,
+            0.01664469118982119, 0.01387612882307075, 0.01189670994589177, 0.01041126526197209,
+            0.009255462182712733, 0.008330563433362871
+        };
+        if (k < 10)
+            return table[k];
+        double k1 = k + 1.0;
+        double k2 = k1 * k1;
+        return (1.0 / 12.0 - (1.0 / 360.0 - 1.0 / 1260.0 / k2) / k2) / k1;
+    }
+
+
+    /**
+      BTRD for p <= 1/2 and np >= 10, with the step numbers of the paper.
+      **/
+    uint64 next_binomial_btrd(uint64 n, double p) {
+        double nd = (double)n;
+        double m = floor((nd + 1.0) * p);
+        double r = p / (1.0 - p);
+        double nr = (nd + 1.0) * r;
+        double npq = nd * p * (1.0 - p);
+        double spq = sqrt(npq);
+        double b = 1.15 + 2.53 * spq;
+        double a = -0.0873 + 0.0248 * b + 0.01 * p;
+        double c = nd * p + 0.5;
+        double alpha = (2.83 + 5.1 / b) * spq;
+        double vr = 0.92 - 4.2 / b;
+        double urvr = 0.86 * vr;
+
+        while (true) {
+            //1: triangle in the center, accepted without further test
+            double v = next_double();
+            if (v <= urvr) {
+                double u = v / vr - 0.43;
+                return (uint64)floor((2.0 * a / (0.5 - fabs(u)) + b) * u + c);
+            }
+
+            //2: point (u, v) under the hat
+            double u;
+            if (v >= vr) {
+                u = next_double() - 0.5;
+            }
+            else {
+                u = v / vr - 0.93;
+                u = (u < 0.0 ? -0.5 : 0.5) - u;
+                v = next_double() * vr;
+            }
+
+            //3.0
+            double us = 0.5 - fabs(u);
+            double kd = floor((2.0 * a / us + b) * u + c);
+            if (kd < 0.0 || kd > nd)
+                continue;
+            v = v * alpha / (a / (us * us) + b);
+            double km = fabs(kd - m);
+
+            //3.1: recursive evaluation of f(k) / f(m) close to the mode
+            if (km <= 15.0) {
+                double f = 1.0;
+                if (m < kd) {
+                    for (double i = m + 1.0; i <= kd; i += 1.0)
+                        f *= nr / i - r;
+                }
+                else if (m > kd) {
+                    for (double i = kd + 1.0; i <= m; i += 1.0)
+                        v *= nr / i - r;
+                }
+                if (v <= f)
+                    return (uint64)kd;
+                continue;
+            }
+
+            //3.2: squeeze on log(v)
+            v = log(v);
+            double rho = (km / npq) * (((km / 3.0 + 0.625) * km + 1.0 / 6.0) / npq + 0.5);
+            double t = -km * km / (2.0 * npq);
+            if (v < t - rho)
+                return (uint64)kd;
+            if (v > t + rho)
+                continue;
+
+            //3.3 and 3.4: final test against log(f(k) / f(m))
+            double nm = nd - m + 1.0;
+            double h = (m + 0.5) * log((m + 1.0) / (r * nm)) + stirling_correction((uint64)m) +
+                       stirling_correction((uint64)(nd - m));
+            double nk = nd - kd + 1.0;
+            if (v <= h + (nd + 1.0) * log(nm / nk) + (kd + 0.5) * log(nk * r / (kd + 1.0)) -
+                     stirling_correction((uint64)kd) - stirling_correction((uint64)(nd - kd)))
+                return (uint64)kd;
+        }
+    }
+};
+
+
+#endif // RNG_H
@@ -0,0 +1,310 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <cmath>
+
+#include "node.h"
+#include "treeutil.h"
+#include "allrootings.h"
+#include "lcaindex.h"
+
+using namespace std;
+
+
+/**
+  Root placement on trees with branch lengths, seen as unrooted: midpoint, minimum variance (Mai et al. 2017) and
+  minimal ancestor deviation (MAD, Tria et al. 2017).  Each method returns the chosen position, which reroot applies.
+  A root with two children is not a node of the unrooted tree, so positions on the edge made of its two edges are
+  given from one of its children, and may exceed the length of that child's own edge.
+  **/
+class TreeRooting {
+public:
+    /**
+      The root goes on the edge above node, at the given distance from node.  score is the value of the criterion
+      (half the diameter, variance or MAD).  node is nullptr if the tree has no edge.
+      **/
+    struct RootPosition {
+        Node* node = nullptr;
+        double distance = 0.0;
+        double score = 0.0;
+    };
+
+
+
+    /**
+      Middle of the longest path between two leaves, found with two farthest leaf searches.  O(n).
+      **/
+    static RootPosition get_midpoint(Node* root) {
+        RootPosition pos;
+        Node* start = root;
+        while (!start->is_leaf())
+            start = start->get_child(0);
+
+        unordered_map<Node*, Node*> pred;
+        double diameter = 0.0;
+        Node* p = get_farthest_leaf(start, pred, diameter);
+        Node* q = get_farthest_leaf(p, pred, diameter);
+        if (p == q)
+            return pos;
+
+        double half = diameter / 2.0;
+        double acc = 0.0;
+        Node* cur = q;
+        while (cur != p) {
+            Node* next = pred[cur];
+            bool up = (next == cur->get_parent());
+            double e = (up ? cur->branch_length : next->branch_length);
+            if (acc + e >= half) {
+                pos.node = (up ? cur : next);
+                pos.distance = (up ? half - acc : e - (half - acc));
+                break;
+            }
+            acc += e;
+            cur = next;
+        }
+        pos.score = half;
+        return pos;
+    }
+
+
+
+    /**
+      Position that minimizes the variance of the root to leaf distances.  AllRootings gives the number of leaves,
+      and the sums of distances and squared distances, on both sides of every edge, and the variance is a
+      quadratic function of the position on the edge.  O(n).
+      **/
+    static RootPosition get_min_variance(Node* root) {
+        PathLengthStat stat;
+        vector<Node*> nodes;
+        vector<PathLengthStat::Value> down, up;
+        vector<double> lengths;
+        AllRootings<PathLengthStat>::compute_sides(root, stat, nodes, down, up, lengths);
+
+        RootPosition best;
+        for (size_t i = 0; i < nodes.size(); ++i) {
+            if (nodes[i]->is_root())
+                continue;
+            const PathLengthStat::Value& a = down[i];
+            const PathLengthStat::Value& b = up[i];
+            double nb = a.nb_leaves + b.nb_leaves;
+            double len = lengths[i];
+
+            auto variance = [&](double x) {
+                double y = len - x;
+                double mean = (a.sum + a.nb_leaves * x + b.sum + b.nb_leaves * y) / nb;
+                double squares = (a.sum_squares + 2.0 * x * a.sum + a.nb_leaves * x * x +
+                                  b.sum_squares + 2.0 * y * b.sum + b.nb_leaves * y * y) / nb;
+                return squares - mean * mean;
+            };
+
+            //variance(x) = alpha x^2 + beta x + variance(0)
+            double diff = (a.nb_leaves - b.nb_leaves) / nb;
+            double alpha = 1.0 - diff * diff;
+            double beta = 2.0 * (a.sum - b.sum - b.nb_leaves * len) / nb - 2.0 * diff * (a.sum + b.sum + b.nb_leaves * len) / nb;
+            double x = (alpha > 0.0 ? -beta / (2.0 * alpha) : 0.0);
+            x = min(max(x, 0.0), len);
+
+            double v = variance(x);
+            if (!best.node || v < best.score) {
+                best.node = nodes[i];
+                best.distance = x;
+                best.score = v;
+            }
+        }
+        return best;
+    }
+
+
+
+    /**
+      MAD rooting: for a root on edge b, each pair of leaves i, j separated by b has the relative deviation
+      2 d(i, root) / d(i, j) - 1, and the root minimizes the root mean square deviation of these pairs.  With A the
+      side of b below node v and x the distance from v to the root, the sum of squared deviations is
+      sum w (c + 2x)^2, with w = 1 / d(i, j)^2 and c = 2 d(i, v) - d(i, j) for i in A, which only needs sums over the
+      pairs separated by b of w, w c' and w c'^2, with c' = 2 depth(i) - d(i, j).  Such a sum is the sum over the
+      leaves of A of their sums over all the leaves, minus the sum over the pairs whose LCA is in the subtree of v,
+      so every edge gets its sums from one pass over the n^2 pairs with an LCAIndex.  O(n^2) time, O(n) memory.
+      Pairs at distance 0 are ignored.
+      **/
+    static RootPosition get_mad(Node* root) {
+        vector<Node*> nodes = root->get_postordered_nodes();
+        int n = nodes.size();
+        unordered_map<Node*, int> index;
+        for (int i = 0; i < n; ++i)
+            index[nodes[i]] = i;
+
+        vector<double> depth(n, 0.0);
+        for (int i = n - 2; i >= 0; --i)
+            depth[i] = depth[index[nodes[i]->get_parent()]] + nodes[i]->branch_length;
+
+        LCAIndex lca_index(root);
+        vector<int> postorder_of(lca_index.get_nb_nodes());
+        for (int i = 0; i < n; ++i)
+            postorder_of[lca_index.get_id(nodes[i])] = i;
+
+        vector<int> leaves, leaf_lca_ids;
+        for (int i = 0; i < n; ++i) {
+            if (nodes[i]->is_leaf()) {
+                leaves.push_back(i);
+                leaf_lca_ids.push_back(lca_index.get_id(nodes[i]));
+            }
+        }
+
+        //per node: sums over (leaf of the node, any leaf) pairs, then over ordered pairs whose LCA is the node
+        vector<array3> rows(n), inner(n);
+        vector<long long> nbleaves(n, 0);
+        for (size_t a = 0; a < leaves.size(); ++a) {
+            int i = leaves[a];
+            int li = leaf_lca_ids[a];
+            for (size_t b = a + 1; b < leaves.size(); ++b) {
+                int j = leaves[b];
+                int l = postorder_of[lca_index.get_lca(li, leaf_lca_ids[b])];
+                double d = depth[i] + depth[j] - 2.0 * depth[l];
+                if (d <= 0.0)
+                    continue;
+                double w = 1.0 / (d * d);
+                double ci = 2.0 * depth[i] - d;
+                double cj = 2.0 * depth[j] - d;
+                array3 fi = { w, w * ci, w * ci * ci };
+                array3 fj = { w, w * cj, w * cj * cj };
+                for (int k = 0; k < 3; ++k) {
+                    rows[i].v[k] += fi.v[k];
+                    rows[j].v[k] += fj.v[k];
+                    inner[l].v[k] += fi.v[k] + fj.v[k];
+                }
+            }
+        }
+
+        for (int i = 0; i < n; ++i) {
+            if (nodes[i]->is_leaf())
+                nbleaves[i] = 1;
+            if (!nodes[i]->is_root()) {
+                int p = index[nodes[i]->get_parent()];
+                nbleaves[p] += nbleaves[i];
+                for (int k = 0; k < 3; ++k) {
+                    rows[p].v[k] += rows[i].v[k];
+                    inner[p].v[k] += inner[i].v[k];
+                }
+            }
+        }
+
+        bool binary_root = (root->get_nb_children() == 2);
+        long long total = leaves.size();
+        RootPosition best;
+        for (int i = 0; i < n; ++i) {
+            Node* v = nodes[i];
+            if (v->is_root())
+                continue;
+            double len = v->branch_length;
+            if (binary_root && v->get_parent() == root)
+                len = root->get_child(0)->branch_length + root->get_child(1)->branch_length;
+
+            double c0 = rows[i].v[0] - inner[i].v[0];
+            double c1 = rows[i].v[1] - inner[i].v[1];
+            double c2 = rows[i].v[2] - inner[i].v[2];
+            if (c0 <= 0.0)
+                continue;
+            double dv = depth[i];
+            double s1 = c1 - 2.0 * dv * c0;
+            double s2 = c2 - 4.0 * dv * c1 + 4.0 * dv * dv * c0;
+
+            double x = min(max(-s1 / (2.0 * c0), 0.0), len);
+            double f = max(0.0, s2 + 4.0 * x * s1 + 4.0 * x * x * c0);
+            double mad = sqrt(f / ((double)nbleaves[i] * (total - nbleaves[i])));
+            if (!best.node || mad < best.score) {
+                best.node = v;
+                best.distance = x;
+                best.score = mad;
+            }
+        }
+        return best;
+    }
+
+
+
+    /**
+      Roots the tree at pos with TreeUtil::reroot_on_edge, and returns the new root (the old one if pos has no node).
+      **/
+    static Node* reroot(Node* root, RootPosition pos) {
+        if (!pos.node)
+            return root;
+
+        Node* v = pos.node;
+        double distance = pos.distance;
+        Node* p = v->get_parent();
+        if (p->is_root() && p->get_nb_children() == 2 && distance > v->branch_length) {
+            distance -= v->branch_length;
+            v = v->get_sibling();
+            distance = max(0.0, v->branch_length - distance);
+        }
+
+        double ratio = (v->branch_length > 0.0 ? min(1.0, distance / v->branch_length) : 0.0);
+        return TreeUtil::reroot_on_edge(v, ratio);
+    }
+
+
+
+    /**
+      Computes the position with method midpoint, minvar or mad, and reroots.  Returns nullptr for an unknown method.
+      **/
+    static Node* reroot(Node* root, const string& method, RootPosition& pos) {
+        if (method == "midpoint")
+            pos = get_midpoint(root);
+        else if (method == "minvar")
+            pos = get_min_variance(root);
+        else if (method == "mad")
+            pos = get_mad(root);
+        else
+            return nullptr;
+        return reroot(root, pos);
+    }
+
+
+
+private:
+    struct array3 {
+        double v[3] = { 0.0, 0.0, 0.0 };
+    };
+
+
+    /**
+      Leaf farthest from start, by path length in the unrooted tree.  Fills pred with the previous node on the
+      path from start to each node, and sets dist to the distance of the returned leaf.
+      **/
+    static Node* get_farthest_leaf(Node* start, unordered_map<Node*, Node*>& pred, double& dist) {
+        pred.clear();
+        Node* best = start;
+        dist = 0.0;
+
+        vector<pair<Node*, double>> stack;
+        stack.push_back(make_pair(start, 0.0));
+        pred[start] = nullptr;
+        while (!stack.empty()) {
+            Node* v = stack.back().first;
+            double d = stack.back().second;
+            stack.pop_back();
+            if (v->is_leaf() && d > dist) {
+                dist = d;
+                best = v;
+            }
+
+            Node* from = pred[v];
+            for (int i = 0; i < v->get_nb_children(); ++i) {
+                Node* c = v->get_child(i);
+                if (c != from) {
+                    pred[c] = v;
+                    stack.push_back(make_pair(c, d + c->branch_length));
+                }
+            }
+            Node* p = v->get_parent();
+            if (p && p != from) {
+                pred[p] = v;
+                stack.push_back(make_pair(p, d + v->branch_length));
+            }
+        }
+        return best;
+    }
+};
@@ -0,0 +1,239 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <algorithm>
+#include <iostream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "node.h"
+#include "newicklex.h"
+#include "util.h"
+#include "rfdistance.h"
+
+using namespace std;
+
+
+/**
+  Reads the trees of a stream with one thread, and parses and processes them with nbthreads worker threads.
+  process(tree, t, i) is called by worker t (0 <= t < nbthreads) for the i-th tree of the stream, in no particular
+  order, and must not delete the tree.  At most
+  4 x nbthreads newick strings wait in the queue, so memory does not depend on the number of trees.
+  **/
+class ParallelTreeReader {
+public:
+
+    template <class F>
+    static long long for_each_tree(istream& in, int nbthreads, F process) {
+        nbthreads = max(1, nbthreads);
+        size_t capacity = 4 * nbthreads;
+        deque<pair<long long, string>> queue;
+        bool done = false;
+        mutex m;
+        condition_variable cv_item, cv_space;
+
+        auto worker = [&](int t) {
+            while (true) {
+                pair<long long, string> item;
+                {
+                    unique_lock<mutex> lock(m);
+                    cv_item.wait(lock, [&] { return !queue.empty() || done; });
+                    if (queue.empty())
+                        break;
+                    item = move(queue.front());
+                    queue.pop_front();
+                }
+                cv_space.notify_one();
+
+                Node* tree = NewickLex::ParseNewickString(item.second);
+                process(tree, t, item.first);
+                delete tree;
+            }
+        };
+
+        vector<thread> threads;
+        for (int t = 0; t < nbthreads; ++t)
+            threads.push_back(thread(worker, t));
+
+        long long nbtrees = 0;
+        string str;
+        while (getline(in, str, ';')) {
+            str = Util::Trim(str);
+            if (str == "")
+                continue;
+            str += ";";
+            {
+                unique_lock<mutex> lock(m);
+                cv_space.wait(lock, [&] { return queue.size() < capacity; });
+                queue.push_back(make_pair(nbtrees, move(str)));
+            }
+            cv_item.notify_one();
+            nbtrees++;
+        }
+
+        {
+            lock_guard<mutex> lock(m);
+            done = true;
+        }
+        cv_item.notify_all();
+        for (thread& th : threads)
+            th.join();
+
+        return nbtrees;
+    }
+};
+
+
+
+
+/**
+  Bootstrap support of the splits of a reference tree: the fraction of the replicate trees that contain each of
+  them.  The reference is hashed once with a BipartitionHasher, which is then frozen, and each replicate is
+  hashed in O(n) and its splits looked up in a hash table of the reference splits.  Replicates are independent,
+  so they are processed in parallel with per-thread counts.
+  **/
+class SplitSupport {
+public:
+    SplitSupport(Node* reference, bool rooted = false) : reference(reference), rooted(rooted) {
+        index_reference();
+    }
+
+
+
+    /**
+      Adds the splits of tree to counts (one per distinct reference split).  Returns false, and leaves counts
+      unchanged, if the leaf set of tree differs from the reference.  Thread-safe.
+      **/
+    bool add_replicate(Node* tree, vector<long long>& counts) {
+        vector<uint64> hashes;
+        uint64 total = 0;
+        int n = hasher.get_splits(tree, rooted, hashes, total);
+        if (n != nbleaves || total != leafset)
+            return false;
+
+        sort(hashes.begin(), hashes.end());
+        hashes.erase(unique(hashes.begin(), hashes.end()), hashes.end());
+        for (uint64 h : hashes) {
+            auto it = split_index.find(h);
+            if (it != split_index.end())
+                counts[it->second]++;
+        }
+        return true;
+    }
+
+
+
+    /**
+      Adds all the trees of the stream as replicates, with nbthreads threads.  Returns the number of trees that
+      were skipped because their leaf set differs from the reference.
+      **/
+    long long add_replicates(istream& in, int nbthreads) {
+        nbthreads = max(1, nbthreads);
+        vector<vector<long long>> thread_counts(nbthreads, vector<long long>(counts.size(), 0));
+        vector<long long> thread_replicates(nbthreads, 0);
+
+        long long nbtrees = ParallelTreeReader::for_each_tree(in, nbthreads, [&](Node* tree, int t, long long) {
+            if (add_replicate(tree, thread_counts[t]))
+                thread_replicates[t]++;
+        });
+
+        long long nbadded = 0;
+        for (int t = 0; t < nbthreads; ++t) {
+            for (size_t s = 0; s < counts.size(); ++s)
+                counts[s] += thread_counts[t][s];
+            nbadded += thread_replicates[t];
+        }
+        nbreplicates += nbadded;
+
+        return nbtrees - nbadded;
+    }
+
+
+    long long get_nb_replicates() {
+        return nbreplicates;
+    }
+
+
+
+    /**
+      Sets the label of each internal node of the reference that has a non-trivial split to its support, as a
+      fraction of the replicates.  Other labels are left as they are.
+      **/
+    void annotate_reference() {
+        for (auto& ns : node_splits) {
+            double support = (nbreplicates > 0 ? (double)counts[ns.second] / nbreplicates : 0.0);
+            ns.first->label = Util::ToString(support);
+        }
+    }
+
+
+
+private:
+    Node* reference;
+    bool rooted;
+    BipartitionHasher hasher;
+    int nbleaves = 0;
+    uint64 leafset = 0;
+
+    unordered_map<uint64, int> split_index;
+    vector<pair<Node*, int>> node_splits;
+    vector<long long> counts;
+    long long nbreplicates = 0;
+
+
+
+    /**
+      Hashes the clade of every node of the reference in postorder, with the same rules as
+      BipartitionHasher::get_splits.  Nodes with one child share the split of their child, and so do the two
+      children of a binary root in an unrooted tree.
+      **/
+    void index_reference() {
+        vector<Node*> nodes = reference->get_postordered_nodes();
+        unordered_map<Node*, pair<uint64, int>> clades;
+        for (Node* v : nodes) {
+            pair<uint64, int> c(0, 0);
+            if (v->is_leaf()) {
+                c.first = hasher.leaf_keys[hasher.get_leaf_id(v->label)];
+                c.second = 1;
+            }
+            else {
+                for (int i = 0; i < v->get_nb_children(); ++i) {
+                    pair<uint64, int>& cc = clades[v->get_child(i)];
+                    c.first ^= cc.first;
+                    c.second += cc.second;
+                }
+            }
+            clades[v] = c;
+        }
+        leafset = clades[reference].first;
+        nbleaves = clades[reference].second;
+        hasher.frozen = true;
+
+        for (Node* v : nodes) {
+            if (v->is_leaf() || v == reference)
+                continue;
+            uint64 h = clades[v].first;
+            int size = clades[v].second;
+            if (size < 2 || size > (rooted ? nbleaves - 1 : nbleaves - 2))
+                continue;
+            if (!rooted)
+                h = min(h, h ^ leafset);
+
+            auto it = split_index.find(h);
+            int s;
+            if (it == split_index.end()) {
+                s = counts.size();
+                split_index[h] = s;
+                counts.push_back(0);
+            }
+            else {
+                s = it->second;
+            }
+            node_splits.push_back(make_pair(v, s));
+        }
+    }
+};
@@ -0,0 +1,421 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <iostream>
+
+#include "node.h"
+#include "util.h"
+#include "support.h"
+
+using namespace std;
+
+
+/**
+  Array of values with range add, and global min and max, in O(log n) per update.  Bottom-up segment tree with
+  non-propagated lazy adds: mn[i] and mx[i] are the min and max of the subtree of i, including the adds of i but
+  not those of its ancestors.
+  **/
+class RangeAddMinMax {
+private:
+    static constexpr long long INF = 1LL << 60;
+
+    int size;
+    vector<long long> mn, mx, lazy;
+
+public:
+    RangeAddMinMax(const vector<long long>& values) {
+        size = 1;
+        while (size < (int)values.size())
+            size *= 2;
+        mn.assign(2 * size, INF);
+        mx.assign(2 * size, -INF);
+        lazy.assign(2 * size, 0);
+        for (size_t i = 0; i < values.size(); ++i)
+            mn[size + i] = mx[size + i] = values[i];
+        for (int i = size - 1; i >= 1; --i)
+            pull(i);
+    }
+
+
+    /**
+      Adds delta to the values of positions [l, r).
+      **/
+    void add(int l, int r, long long delta) {
+        int l0 = l + size, r0 = r - 1 + size;
+        for (l += size, r += size; l < r; l >>= 1, r >>= 1) {
+            if (l & 1)
+                apply(l++, delta);
+            if (r & 1)
+                apply(--r, delta);
+        }
+        for (l0 >>= 1; l0 >= 1; l0 >>= 1)
+            pull(l0);
+        for (r0 >>= 1; r0 >= 1; r0 >>= 1)
+            pull(r0);
+    }
+
+
+    long long get_min() {
+        return mn[1];
+    }
+
+    long long get_max() {
+        return mx[1];
+    }
+
+
+private:
+    void apply(int i, long long delta) {
+        mn[i] += delta;
+        mx[i] += delta;
+        lazy[i] += delta;
+    }
+
+    void pull(int i) {
+        mn[i] = min(mn[2 * i], mn[2 * i + 1]) + lazy[i];
+        mx[i] = max(mx[2 * i], mx[2 * i + 1]) + lazy[i];
+    }
+};
+
+
+
+
+/**
+  Transfer bootstrap expectation (TBE, Lemoine et al. 2018) of the branches of a reference tree.  For a reference
+  branch whose light side has p >= 2 leaves, the transfer distance to a replicate tree T is the minimum, over the
+  branches of T, of the number of leaves to move to turn one bipartition into the other, and its support is
+  1 - (mean transfer distance over the replicates) / (p - 1).
+  With A the clade of a reference node and C_v the clade of a node v of T, the distance to the branch above v is
+  min(d, n - d) with d = |A| + |C_v| - 2 |A & C_v|.  T is heavy-path decomposed, and y_v = |C_v| - 2 |A & C_v| is
+  kept in a RangeAddMinMax: adding a leaf to A is a path update to the root of T, and the distance of A is
+  min(|A| + min y, n - |A| - max y).  The reference is swept so that each node inherits the leaves of its heavy
+  child and adds those of its light children (each leaf is added O(log n) times), which gives O(n log^3 n) per
+  replicate instead of O(n^2).  The sequence of adds, removes and queries is computed once from the reference.
+  **/
+class TransferSupport {
+public:
+    TransferSupport(Node* reference) : reference(reference) {
+        index_reference();
+    }
+
+
+
+    /**
+      Adds the transfer distance of each reference branch to tree to distances (one per supported reference node).
+      Returns false, and leaves distances unchanged, if the leaf set of tree differs from the reference.
+      Thread-safe.
+      **/
+    bool add_replicate(Node* tree, vector<double>& distances) {
+        vector<int> leaf_nodes;
+        vector<int> parent, head, pos;
+        vector<long long> values;
+        if (!decompose(tree, leaf_nodes, parent, head, pos, values))
+            return false;
+
+        RangeAddMinMax y(values);
+        auto add_leaf = [&](int k, long long delta) {
+            for (int x = leaf_nodes[k]; x != -1; x = parent[head[x]])
+                y.add(pos[head[x]], pos[x] + 1, delta);
+        };
+
+        for (const Event& e : events) {
+            if (e.type == ADD) {
+                for (int k = e.a; k < e.b; ++k)
+                    add_leaf(k, -2);
+            }
+            else if (e.type == REMOVE) {
+                for (int k = e.a; k < e.b; ++k)
+                    add_leaf(k, 2);
+            }
+            else {
+                long long a = query_sizes[e.a];
+                long long d = min(a + y.get_min(), nbleaves - a - y.get_max());
+                distances[e.a] += d;
+            }
+        }
+
+        return true;
+    }
+
+
+
+    /**
+      Same as add_replicate, by computing |A & C_v| for every reference clade A and node v of tree, in O(n^2).
+      Used as a reference for tests and benchmarks.
+      **/
+    bool add_replicate_naive(Node* tree, vector<double>& distances) {
+        vector<int> leaf_nodes;
+        vector<int> parent, head, pos;
+        vector<long long> values;
+        if (!decompose(tree, leaf_nodes, parent, head, pos, values))
+            return false;
+
+        //nodes are numbered in preorder by decompose, so parents come before their children
+        int nbnodes = parent.size();
+        vector<long long> inter(nbnodes);
+        for (size_t q = 0; q < query_sizes.size(); ++q) {
+            fill(inter.begin(), inter.end(), 0);
+            for (int k = query_ranges[q].first; k < query_ranges[q].second; ++k)
+                inter[leaf_nodes[k]] = 1;
+            for (int v = nbnodes - 1; v > 0; --v)
+                inter[parent[v]] += inter[v];
+
+            long long a = query_sizes[q];
+            long long best = nbleaves;
+            for (int v = 0; v < nbnodes; ++v) {
+                long long d = a + values[pos[v]] - 2 * inter[v];
+                best = min(best, min(d, nbleaves - d));
+            }
+            distances[q] += best;
+        }
+
+        return true;
+    }
+
+
+
+    /**
+      Adds all the trees of the stream as replicates, with nbthreads threads.  Returns the number of trees that
+      were skipped because their leaf set differs from the reference.
+      **/
+    long long add_replicates(istream& in, int nbthreads) {
+        nbthreads = max(1, nbthreads);
+        vector<vector<double>> thread_distances(nbthreads, vector<double>(distances.size(), 0.0));
+        vector<long long> thread_replicates(nbthreads, 0);
+
+        long long nbtrees = ParallelTreeReader::for_each_tree(in, nbthreads, [&](Node* tree, int t, long long) {
+            if (add_replicate(tree, thread_distances[t]))
+                thread_replicates[t]++;
+        });
+
+        long long nbadded = 0;
+        for (int t = 0; t < nbthreads; ++t) {
+            for (size_t q = 0; q < distances.size(); ++q)
+                distances[q] += thread_distances[t][q];
+            nbadded += thread_replicates[t];
+        }
+        nbreplicates += nbadded;
+
+        return nbtrees - nbadded;
+    }
+
+
+    long long get_nb_replicates() {
+        return nbreplicates;
+    }
+
+
+    int get_nb_queries() {
+        return query_sizes.size();
+    }
+
+
+
+    /**
+      Sets the label of each reference node whose branch has a light side of at least 2 leaves to its TBE, computed
+      from the given sums of transfer distances over nb replicates (by default, those added by add_replicates).
+      **/
+    void annotate_reference() {
+        annotate_reference(distances, nbreplicates);
+    }
+
+    void annotate_reference(const vector<double>& sums, long long nb) {
+        for (size_t q = 0; q < query_nodes.size(); ++q) {
+            long long p = min(query_sizes[q], nbleaves - query_sizes[q]);
+            double support = (nb > 0 ? 1.0 - sums[q] / nb / (p - 1) : 0.0);
+            query_nodes[q]->label = Util::ToString(support);
+        }
+    }
+
+
+
+private:
+    enum EventType { ADD, REMOVE, QUERY };
+
+    struct Event {
+        EventType type;
+        int a, b;       //leaf positions [a, b) for ADD and REMOVE, query index in a for QUERY
+    };
+
+    Node* reference;
+    int nbleaves = 0;
+    unordered_map<string, int> label_to_position;
+    vector<Event> events;
+
+    vector<Node*> query_nodes;
+    vector<long long> query_sizes;
+    vector<pair<int, int>> query_ranges;
+
+    vector<double> distances;
+    long long nbreplicates = 0;
+
+
+
+    /**
+      Orders the leaves of the reference by a DFS that visits heavy children last, so that every clade is a range
+      of positions, and records the events of the sweep: when a node is done, the leaves of its light children are
+      added (the heavy child left its own), its query is made, and if it is itself a light child, its leaves are
+      removed.
+      **/
+    void index_reference() {
+        vector<Node*> nodes = reference->get_postordered_nodes();
+        unordered_map<Node*, int> sizes;
+        for (Node* v : nodes) {
+            int s = (v->is_leaf() ? 1 : 0);
+            for (int i = 0; i < v->get_nb_children(); ++i)
+                s += sizes[v->get_child(i)];
+            sizes[v] = s;
+        }
+        nbleaves = sizes[reference];
+
+        struct Frame {
+            Node* v;
+            vector<Node*> children;     //heavy child last
+            size_t next;
+            int first;
+        };
+
+        int nextpos = 0;
+        vector<Frame> stack;
+        auto push = [&](Node* v) {
+            Frame f = { v, {}, 0, nextpos };
+            for (int i = 0; i < v->get_nb_children(); ++i)
+                f.children.push_back(v->get_child(i));
+            if (!f.children.empty()) {
+                auto heavy = max_element(f.children.begin(), f.children.end(), [&](Node* a, Node* b) {
+                    return sizes[a] < sizes[b];
+                });
+                iter_swap(heavy, f.children.end() - 1);
+            }
+            stack.push_back(f);
+        };
+        push(reference);
+
+        while (!stack.empty()) {
+            Frame& f = stack.back();
+            if (f.next < f.children.size()) {
+                Node* c = f.children[f.next++];
+                push(c);
+                continue;
+            }
+
+            Frame done = stack.back();
+            stack.pop_back();
+            Node* v = done.v;
+            int end;
+            if (v->is_leaf()) {
+                label_to_position[v->label] = nextpos;
+                end = ++nextpos;
+                events.push_back({ ADD, done.first, end });
+            }
+            else {
+                end = nextpos;
+                int heavy_first = end - sizes[done.children.back()];
+                if (done.first < heavy_first)
+                    events.push_back({ ADD, done.first, heavy_first });
+            }
+
+            int s = end - done.first;
+            if (v != reference && min(s, nbleaves - s) >= 2) {
+                events.push_back({ QUERY, (int)query_nodes.size(), 0 });
+                query_nodes.push_back(v);
+                query_sizes.push_back(s);
+                query_ranges.push_back(make_pair(done.first, end));
+            }
+
+            bool is_heavy = !stack.empty() && stack.back().next == stack.back().children.size();
+            if (!stack.empty() && !is_heavy)
+                events.push_back({ REMOVE, done.first, end });
+        }
+
+        distances.assign(query_nodes.size(), 0.0);
+    }
+
+
+
+    /**
+      Heavy path decomposition of tree, with nodes numbered in preorder.  leaf_nodes[k] is the node of the leaf at
+      reference position k, and values[pos[v]] = |C_v|.  Returns false if the leaf set differs from the reference.
+      **/
+    bool decompose(Node* tree, vector<int>& leaf_nodes, vector<int>& parent, vector<int>& head, vector<int>& pos,
+                   vector<long long>& values) {
+        vector<Node*> preorder;
+        vector<pair<Node*, int>> stack;
+        stack.push_back(make_pair(tree, -1));
+        leaf_nodes.assign(nbleaves, -1);
+        int nbfound = 0;
+        while (!stack.empty()) {
+            Node* v = stack.back().first;
+            int p = stack.back().second;
+            stack.pop_back();
+
+            int id = preorder.size();
+            preorder.push_back(v);
+            parent.push_back(p);
+            if (v->is_leaf()) {
+                auto it = label_to_position.find(v->label);
+                if (it == label_to_position.end() || leaf_nodes[it->second] != -1)
+                    return false;
+                leaf_nodes[it->second] = id;
+                nbfound++;
+            }
+            for (int i = v->get_nb_children() - 1; i >= 0; --i)
+                stack.push_back(make_pair(v->get_child(i), id));
+        }
+        if (nbfound != nbleaves)
+            return false;
+
+        int nbnodes = preorder.size();
+        vector<long long> sizes(nbnodes, 0);
+        vector<int> heavy(nbnodes, -1);
+        for (int v = nbnodes - 1; v >= 0; --v) {
+            if (preorder[v]->is_leaf())
+                sizes[v] = 1;
+            int p = parent[v];
+            if (p != -1) {
+                sizes[p] += sizes[v];
+                if (heavy[p] == -1 || sizes[v] > sizes[heavy[p]])
+                    heavy[p] = v;
+            }
+        }
+
+        //children in CSR form, then a DFS that takes heavy children first so that heavy paths are contiguous
+        vector<int> offsets(nbnodes + 1, 0);
+        for (int v = 1; v < nbnodes; ++v)
+            offsets[parent[v] + 1]++;
+        for (int v = 0; v < nbnodes; ++v)
+            offsets[v + 1] += offsets[v];
+        vector<int> children(max(0, nbnodes - 1));
+        vector<int> fill_pos(offsets.begin(), offsets.end() - 1);
+        for (int v = 1; v < nbnodes; ++v)
+            children[fill_pos[parent[v]]++] = v;
+
+        head.assign(nbnodes, 0);
+        pos.assign(nbnodes, 0);
+        values.assign(nbnodes, 0);
+        int nextpos = 0;
+        vector<int> dfs = { 0 };
+        while (!dfs.empty()) {
+            int v = dfs.back();
+            dfs.pop_back();
+            pos[v] = nextpos++;
+            values[pos[v]] = sizes[v];
+            for (int i = offsets[v]; i < offsets[v + 1]; ++i) {
+                int c = children[i];
+                if (c != heavy[v]) {
+                    head[c] = c;
+                    dfs.push_back(c);
+                }
+            }
+            if (heavy[v] != -1) {
+                head[heavy[v]] = head[v];
+                dfs.push_back(heavy[v]);
+            }
+        }
+
+        return true;
+    }
+};
@@ -0,0 +1,276 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <cstring>
+
+#include "define.h"
+#include "node.h"
+#include "rng.h"
+
+using namespace std;
+
+
+/**
+  Canonical 64 bits hashes of trees, equal for trees that are the same up to the order of children: AHU-style
+  labelling, where a leaf is hashed from its label and an internal node from the sorted hashes of its child
+  edges, so a tree of size n is hashed in O(n log n).  Internal labels are ignored, and so are branch lengths
+  unless use_lengths is set, in which case they must be bitwise equal (the lengths of paths through nodes of
+  degree 2 are summed, so rerootings that split and merge edges may round them differently).
+  The rooted hash passes nodes with one child through.  The unrooted hash works on the tree without its nodes of
+  degree 2 (the root when it has two children, and nodes with one child), rooted at its center: the
+  middle node, or middle edge, of its longest path, which does not depend on the rooting.
+  Hashes are deterministic, so they can be compared across runs.  Different topologies collide with
+  probability about 2^-64 per pair.
+  **/
+class TopologyHasher {
+public:
+    bool use_lengths;
+
+    TopologyHasher(bool use_lengths = false) : use_lengths(use_lengths) {}
+
+
+
+    uint64 get_hash(Node* root, bool rooted) {
+        return (rooted ? get_rooted_hash(root) : get_unrooted_hash(root));
+    }
+
+
+
+    uint64 get_rooted_hash(Node* root) {
+        vector<Node*> nodes = root->get_postordered_nodes();
+        unordered_map<Node*, pair<uint64, double>> hashes;      //hash, length of the chain of unary nodes below
+        vector<uint64> edges;
+
+        for (Node* v : nodes) {
+            pair<uint64, double> h(0, 0.0);
+            if (v->is_leaf()) {
+                h.first = hash_leaf(v->label);
+            }
+            else if (v->get_nb_children() == 1) {
+                Node* c = v->get_child(0);
+                h = hashes[c];
+                h.second += c->branch_length;
+            }
+            else {
+                edges.clear();
+                for (int i = 0; i < v->get_nb_children(); ++i) {
+                    Node* c = v->get_child(i);
+                    pair<uint64, double>& hc = hashes[c];
+                    edges.push_back(hash_edge(hc.first, c->branch_length + hc.second));
+                }
+                h.first = hash_node(edges);
+            }
+            hashes[v] = h;
+        }
+
+        return mix(hashes[root].first ^ ROOTED_SEED);
+    }
+
+
+
+    uint64 get_unrooted_hash(Node* root) {
+        vector<vector<pair<int, double>>> graph;
+        vector<Node*> kept;
+        build_unrooted_graph(root, graph, kept);
+        int m = graph.size();
+
+        //peel the leaves layer by layer until one or two nodes remain
+        vector<int> degrees(m);
+        vector<int> layer;
+        for (int i = 0; i < m; ++i) {
+            degrees[i] = graph[i].size();
+            if (degrees[i] <= 1)
+                layer.push_back(i);
+        }
+        int remaining = m;
+        vector<int> next;
+        while (remaining > 2) {
+            next.clear();
+            for (int v : layer) {
+                remaining--;
+                for (auto& e : graph[v]) {
+                    if (--degrees[e.first] == 1)
+                        next.push_back(e.first);
+                }
+            }
+            layer.swap(next);
+        }
+
+        if (layer.size() == 1) {
+            return mix(hash_subtree(graph, kept, layer[0], -1) ^ UNROOTED_NODE_SEED);
+        }
+
+        int u = layer[0], v = layer[1];
+        double length = 0.0;
+        for (auto& e : graph[u]) {
+            if (e.first == v)
+                length = e.second;
+        }
+        uint64 hu = hash_subtree(graph, kept, u, v);
+        uint64 hv = hash_subtree(graph, kept, v, u);
+        uint64 h = mix(mix(UNROOTED_EDGE_SEED ^ min(hu, hv)) ^ max(hu, hv));
+        if (use_lengths)
+            h = mix(h ^ length_bits(length));
+        return h;
+    }
+
+
+
+private:
+    static constexpr uint64 LEAF_SEED = 0x6A09E667F3BCC908ULL;
+    static constexpr uint64 NODE_SEED = 0xBB67AE8584CAA73BULL;
+    static constexpr uint64 ROOTED_SEED = 0x3C6EF372FE94F82BULL;
+    static constexpr uint64 UNROOTED_NODE_SEED = 0xA54FF53A5F1D36F1ULL;
+    static constexpr uint64 UNROOTED_EDGE_SEED = 0x510E527FADE682D1ULL;
+
+
+    static uint64 mix(uint64 x) {
+        return Rng::splitmix64(x);
+    }
+
+
+    static uint64 length_bits(double length) {
+        if (length == 0.0)
+            length = 0.0;       //same bits for -0
+        uint64 bits;
+        memcpy(&bits, &length, sizeof(bits));
+        return bits;
+    }
+
+
+    /**
+      FNV-1a of the label, then mixed.
+      **/
+    static uint64 hash_leaf(const string& label) {
+        uint64 h = 0xCBF29CE484222325ULL;
+        for (char c : label) {
+            h ^= (unsigned char)c;
+            h *= 0x100000001B3ULL;
+        }
+        return mix(h ^ LEAF_SEED);
+    }
+
+
+    uint64 hash_edge(uint64 child, double length) {
+        return (use_lengths ? mix(child ^ mix(length_bits(length))) : child);
+    }
+
+
+    /**
+      Sorts edges, so that the hash does not depend on the order of the children.
+      **/
+    static uint64 hash_node(vector<uint64>& edges) {
+        sort(edges.begin(), edges.end());
+        uint64 h = mix(NODE_SEED ^ edges.size());
+        for (uint64 e : edges)
+            h = mix(h ^ e);
+        return h;
+    }
+
+
+
+    /**
+      Undirected graph of the tree without its nodes of degree 2: graph[i] lists the neighbours of kept[i] with
+      the lengths of the paths to them.  Path lengths are summed in sorted order, so that they do not depend on
+      the direction of the path.
+      **/
+    static void build_unrooted_graph(Node* root, vector<vector<pair<int, double>>>& graph, vector<Node*>& kept) {
+        vector<Node*> nodes = root->get_postordered_nodes();
+        unordered_map<Node*, int> ids;
+        for (Node* v : nodes) {
+            int degree = v->get_nb_children() + (v->is_root() ? 0 : 1);
+            if (degree != 2) {
+                ids[v] = kept.size();
+                kept.push_back(v);
+            }
+        }
+        graph.assign(kept.size(), vector<pair<int, double>>());
+
+        //walk from each kept node through each neighbour until the next kept node
+        vector<double> lengths;
+        for (size_t i = 0; i < kept.size(); ++i) {
+            Node* start = kept[i];
+            vector<Node*> neighbours;
+            for (int k = 0; k < start->get_nb_children(); ++k)
+                neighbours.push_back(start->get_child(k));
+            if (!start->is_root())
+                neighbours.push_back(start->get_parent());
+
+            for (Node* first : neighbours) {
+                Node* prev = start;
+                Node* cur = first;
+                lengths.clear();
+                while (true) {
+                    lengths.push_back(cur->get_parent() == prev ? cur->branch_length : prev->branch_length);
+                    auto it = ids.find(cur);
+                    if (it != ids.end()) {
+                        sort(lengths.begin(), lengths.end());
+                        double length = 0.0;
+                        for (double l : lengths)
+                            length += l;
+                        graph[i].push_back(make_pair(it->second, length));
+                        break;
+                    }
+                    //cur has degree 2: continue through its other neighbour
+                    Node* other = nullptr;
+                    for (int k = 0; k < cur->get_nb_children() && !other; ++k) {
+                        if (cur->get_child(k) != prev)
+                            other = cur->get_child(k);
+                    }
+                    if (!other)
+                        other = cur->get_parent();
+                    prev = cur;
+                    cur = other;
+                }
+            }
+        }
+    }
+
+
+
+    /**
+      Rooted hash of the graph rooted at r, without the side of excluded (-1 for none).  Nodes that were leaves of
+      the tree (including a root with one child) are hashed from their label.
+      **/
+    uint64 hash_subtree(const vector<vector<pair<int, double>>>& graph, const vector<Node*>& kept, int r, int excluded) {
+        int m = graph.size();
+        vector<int> order;
+        vector<int> parents(m, -1);
+        vector<double> lengths(m, 0.0);
+        vector<int> stack;
+        stack.push_back(r);
+        parents[r] = excluded;
+        while (!stack.empty()) {
+            int v = stack.back();
+            stack.pop_back();
+            order.push_back(v);
+            for (auto& e : graph[v]) {
+                if (e.first != parents[v]) {
+                    parents[e.first] = v;
+                    lengths[e.first] = e.second;
+                    stack.push_back(e.first);
+                }
+            }
+        }
+
+        vector<uint64> hashes(m, 0);
+        vector<uint64> edges;
+        for (int k = order.size() - 1; k >= 0; --k) {
+            int v = order[k];
+            if (kept[v]->get_nb_children() == 0 || (kept[v]->is_root() && kept[v]->get_nb_children() == 1)) {
+                hashes[v] = hash_leaf(kept[v]->label);
+                continue;
+            }
+            edges.clear();
+            for (auto& e : graph[v]) {
+                if (e.first != parents[v])
+                    edges.push_back(hash_edge(hashes[e.first], lengths[e.first]));
+            }
+            hashes[v] = hash_node(edges);
+        }
+        return hashes[r];
+    }
+};
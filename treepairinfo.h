@@ -0,0 +1,371 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <cstring>
+#include <cstdint>
+
+#include "node.h"
+#include "ewah/ewah.h"
+
+using namespace std;
+
+
+typedef ewah::EWAHBoolArray<uint32_t> bitmap;
+
+
+
+
+
+struct NodeInfo {
+	int id;
+	int size;	//number of leaves in the clade
+	bitmap clade;
+	bitmap clade_comp;	//complement of the clade
+};
+
+
+
+
+/**
+  Bipartite incompatibility graph between the nodes of two trees, stored in compressed sparse row form.
+  The nodes of t1 (resp. t2) are given dense ids 0..n1-1 (resp. 0..n2-1) following the postorder.
+  The t2 neighbours of the t1 node i are neighbours[offsets[i]], ..., neighbours[offsets[i + 1] - 1].
+
+  The binary dump is meant to be mmapped by downstream solvers.  Its layout, in host byte order, is
+  a 32 bytes header (8 bytes magic "TUINCG1", then n1, n2 and nb_edges as uint64), followed by the
+  n1 + 1 offsets as uint64 and the nb_edges neighbours as uint32.
+  **/
+struct IncompatGraph {
+	uint64_t n1 = 0;
+	uint64_t n2 = 0;
+	vector<uint64_t> offsets;
+	vector<uint32_t> neighbours;
+
+	//not persisted, only available when the graph was built from a TreePairInfo
+	vector<Node*> t1_nodes;
+	vector<Node*> t2_nodes;
+
+
+	uint64_t get_nb_edges() const {
+		return neighbours.size();
+	}
+
+	uint64_t get_degree(uint64_t i) const {
+		return offsets[i + 1] - offsets[i];
+	}
+
+
+	bool write_binary(const string& filename) const {
+		ofstream out(filename, ios::binary);
+		if (!out)
+			return false;
+
+		char magic[8] = "TUINCG1";
+		uint64_t header[3] = { n1, n2, get_nb_edges() };
+		out.write(magic, 8);
+		out.write((const char*)header, sizeof(header));
+		out.write((const char*)offsets.data(), offsets.size() * sizeof(uint64_t));
+		out.write((const char*)neighbours.data(), neighbours.size() * sizeof(uint32_t));
+
+		return (bool)out;
+	}
+
+
+	/**
+	  Reads a graph written by write_binary.  Returns false if the file is missing or is not an incompatibility graph.
+	  **/
+	bool read_binary(const string& filename) {
+		ifstream in(filename, ios::binary);
+		if (!in)
+			return false;
+
+		char magic[8];
+		uint64_t header[3];
+		in.read(magic, 8);
+		in.read((char*)header, sizeof(header));
+		if (!in || strncmp(magic, "TUINCG1", 8) != 0)
+			return false;
+
+		n1 = header[0];
+		n2 = header[1];
+		offsets.resize(n1 + 1);
+		neighbours.resize(header[2]);
+		in.read((char*)offsets.data(), offsets.size() * sizeof(uint64_t));
+		in.read((char*)neighbours.data(), neighbours.size() * sizeof(uint32_t));
+		t1_nodes.clear();
+		t2_nodes.clear();
+
+		return (bool)in;
+	}
+};
+
+
+
+
+
+struct TreePairInfo {
+	Node* t1;
+	Node* t2;
+	map<string, int> label_to_leafid;
+	vector<string> leafid_to_label;
+	map<Node*, NodeInfo> infos;
+
+	//nodes of each tree in postorder, the position of a node is its dense id
+	vector<Node*> t1_nodes;
+	vector<Node*> t2_nodes;
+
+
+	bitmap _all_ones;	//temp variable
+
+	int cpt_id, leaf_id;
+	int nb_leaves;
+
+	TreePairInfo(Node* t1, Node* t2) : t1(t1), t2(t2) {
+		cpt_id = 1;
+		leaf_id = 1;
+		leafid_to_label.push_back("");	//leaf ids start at 1
+
+
+		//count leaves, losing time...
+		nb_leaves = 0;
+		for (auto it = t1->begin(); it != t1->end(); ++it) {
+			if ((*it)->is_leaf()) {
+				nb_leaves++;
+				_all_ones.set(nb_leaves);
+			}
+		}
+
+
+		preprocess_tree_rec(t1, true);
+
+		preprocess_tree_rec(t2, false);
+
+		t1_nodes = t1->get_postordered_nodes();
+		t2_nodes = t2->get_postordered_nodes();
+	}
+
+	void preprocess_tree_rec(Node* v, bool is_tree1) {
+
+		infos[v].id = cpt_id;
+		cpt_id++;
+
+		if (v->is_leaf()) {
+
+			if (is_tree1) {
+				infos[v].id = leaf_id;
+
+				infos[v].clade.set(leaf_id);
+				infos[v].clade_comp = _all_ones.logicalandnot(infos[v].clade);
+
+				label_to_leafid[v->label] = leaf_id;
+				leafid_to_label.push_back(v->label);
+				leaf_id++;
+			}
+			else {
+				infos[v].id = label_to_leafid[v->label];
+				infos[v].clade.set(infos[v].id);
+				infos[v].clade_comp = _all_ones.logicalandnot(infos[v].clade);
+			}
+			infos[v].size = 1;
+
+		}
+		else {
+			infos[v].size = 0;
+			for (int i = 0; i < v->get_nb_children(); ++i) {
+				preprocess_tree_rec(v->get_child(i), is_tree1);
+
+				if (i == 0)
+					infos[v].clade = infos[v->get_child(i)].clade;
+				else
+					infos[v].clade = infos[v].clade | infos[v->get_child(i)].clade;
+				infos[v].size += infos[v->get_child(i)].size;
+			}
+			infos[v].clade_comp = _all_ones.logicalandnot(infos[v].clade);
+		}
+	}
+
+
+
+	/**
+	  Two clades are incompatible iff the four intersections between them and their complements are non-empty.
+	  Clades with at most one leaf on one side are compatible with everything, so they are skipped early.
+	  **/
+	bool is_trivial(const NodeInfo& info) {
+		return (info.size <= 1 || info.size >= nb_leaves - 1);
+	}
+
+	bool are_incompatible(const NodeInfo& i1, const NodeInfo& i2) {
+		return i1.clade.intersects(i2.clade) && i1.clade.intersects(i2.clade_comp) &&
+			i1.clade_comp.intersects(i2.clade) && i1.clade_comp.intersects(i2.clade_comp);
+	}
+
+
+	/**
+	  Calls f(i, j) for every incompatible pair formed by the t1 node of dense id i and the t2 node of dense id j,
+	  with i and j in increasing order.  The scan stops as soon as f returns false.
+	  **/
+	template <class F>
+	void for_each_incompat(F f) {
+		vector<const NodeInfo*> infos2;
+		vector<uint32_t> nontrivial2;
+		for (uint32_t j = 0; j < t2_nodes.size(); ++j) {
+			infos2.push_back(&infos[t2_nodes[j]]);
+			if (!is_trivial(*infos2.back()))
+				nontrivial2.push_back(j);
+		}
+
+		for (uint32_t i = 0; i < t1_nodes.size(); ++i) {
+			const NodeInfo& info1 = infos[t1_nodes[i]];
+			if (is_trivial(info1))
+				continue;
+
+			for (uint32_t j : nontrivial2) {
+				if (are_incompatible(info1, *infos2[j]) && !f(i, j))
+					return;
+			}
+		}
+	}
+
+
+	/**
+	  Builds the incompatibility relation as a CSR bipartite graph over the dense node ids.
+	  **/
+	IncompatGraph get_incompat_graph() {
+		IncompatGraph g;
+		g.n1 = t1_nodes.size();
+		g.n2 = t2_nodes.size();
+		g.t1_nodes = t1_nodes;
+		g.t2_nodes = t2_nodes;
+		g.offsets.assign(g.n1 + 1, 0);
+
+		//neighbours arrive sorted by i, so the offsets are filled as counts then prefix-summed
+		for_each_incompat([&](uint32_t i, uint32_t j) {
+			g.offsets[i + 1]++;
+			g.neighbours.push_back(j);
+			return true;
+		});
+
+		for (uint64_t i = 0; i < g.n1; ++i)
+			g.offsets[i + 1] += g.offsets[i];
+
+		return g;
+	}
+
+
+	/**
+	  Number of incompatible pairs, without storing them.
+	  **/
+	uint64_t count_incompats() {
+		uint64_t cpt = 0;
+		for_each_incompat([&](uint32_t i, uint32_t j) {
+			cpt++;
+			return true;
+		});
+		return cpt;
+	}
+
+
+	/**
+	  Returns true iff the two trees are compatible, i.e. have no incompatible pair.  Stops at the first incompatibility.
+	  **/
+	bool are_compatible() {
+		bool compatible = true;
+		for_each_incompat([&](uint32_t i, uint32_t j) {
+			compatible = false;
+			return false;
+		});
+		return compatible;
+	}
+
+
+
+	/**
+	  Leaf ids on the side of the split defined by the node that does not contain leaf 1.  Normalizing this way
+	  turns any set of pairwise compatible splits into a laminar family of clades.
+	  **/
+	vector<size_t> get_split_side(const NodeInfo& info) {
+		if (info.clade.get(1))
+			return info.clade_comp.toArray();
+		return info.clade.toArray();
+	}
+
+
+
+	/**
+	  Builds the tree displaying the nodes of t1 with keep1[id] and the nodes of t2 with keep2[id] (dense ids),
+	  which must be pairwise compatible, e.g. the output of BipartiteMWIS.  This is a common refinement of the
+	  selected parts of t1 and t2.  The tree is rooted arbitrarily on leaf 1's side, clades that appear twice are
+	  only created once, and each edge takes the branch length of the node it comes from.
+	  User has to delete returned value.
+	  **/
+	Node* build_refinement(const vector<bool>& keep1, const vector<bool>& keep2) {
+		vector<pair<Node*, vector<size_t>>> sides;
+		for (size_t i = 0; i < t1_nodes.size(); ++i) {
+			if (keep1[i] && !is_trivial(infos[t1_nodes[i]]))
+				sides.push_back(make_pair(t1_nodes[i], get_split_side(infos[t1_nodes[i]])));
+		}
+		for (size_t j = 0; j < t2_nodes.size(); ++j) {
+			if (keep2[j] && !is_trivial(infos[t2_nodes[j]]))
+				sides.push_back(make_pair(t2_nodes[j], get_split_side(infos[t2_nodes[j]])));
+		}
+
+		//in a laminar family sorted by decreasing size, the parent of a clade is the last one that took any of its leaves
+		stable_sort(sides.begin(), sides.end(), [](const pair<Node*, vector<size_t>>& a, const pair<Node*, vector<size_t>>& b) {
+			return a.second.size() > b.second.size();
+		});
+
+		Node* root = new Node();
+		vector<Node*> deepest(nb_leaves + 1, root);
+		map<Node*, size_t> sizes;
+		sizes[root] = nb_leaves;
+
+		for (auto& side : sides) {
+			vector<size_t>& leaves = side.second;
+			if (leaves.size() < 2)
+				continue;
+
+			Node* parent = deepest[leaves[0]];
+			if (sizes[parent] == leaves.size())
+				continue;	//same clade already created
+
+			Node* w = parent->add_child();
+			w->label = side.first->label;
+			w->branch_length = side.first->branch_length;
+			sizes[w] = leaves.size();
+			for (size_t leaf : leaves)
+				deepest[leaf] = w;
+		}
+
+		vector<double> leaf_lengths(nb_leaves + 1, 0.0);
+		for (Node* v : t1_nodes) {
+			if (v->is_leaf())
+				leaf_lengths[infos[v].id] = v->branch_length;
+		}
+
+		for (int leaf = 1; leaf <= nb_leaves; ++leaf) {
+			Node* v = deepest[leaf]->add_child();
+			v->label = leafid_to_label[leaf];
+			v->branch_length = leaf_lengths[leaf];
+		}
+
+		return root;
+	}
+
+
+
+	map<Node*, vector<Node*>> get_imcompats() {
+
+		map<Node*, vector<Node*>> ret;
+		for_each_incompat([&](uint32_t i, uint32_t j) {
+			ret[t1_nodes[i]].push_back(t2_nodes[j]);
+			return true;
+		});
+
+		return ret;
+	}
+
+
+};
@@ -0,0 +1,290 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#include "node.h"
+#include "treeutil.h"
+#include "rng.h"
+
+using namespace std;
+
+
+/**
+  Applies random NNI, SPR or TBR moves to a tree, in place, to produce trees at a controlled distance from it.
+  Nodes are kept in a vector (with their index in a map) so that random nodes are drawn in O(1), and candidate
+  moves are drawn by rejection: a move costs O(path length) for the ancestor checks, plus O(degree) for the
+  child lists.  The root is never moved, and degree 2 nodes left by a prune are suppressed (their branch
+  lengths merged), so binary trees stay binary.  Works on rooted trees and on unrooted trees with a degree 3 root.
+  **/
+class TreePerturber {
+private:
+    Node* root;
+    Rng& rng;
+    vector<Node*> nodes;
+    unordered_map<Node*, size_t> index;
+
+    static constexpr int MAX_ATTEMPTS = 1000;
+
+public:
+    TreePerturber(Node* root, Rng& rng) : root(root), rng(rng) {
+        for (Node* v : *root)
+            add_node(v);
+    }
+
+
+
+    /**
+      Applies k moves of the given type (nni, spr or tbr), and returns the number of moves that could be applied
+      (less than k only if the tree is too small for the move).
+      **/
+    int perturb(int k, const string& move) {
+        int nbdone = 0;
+        for (int i = 0; i < k; ++i) {
+            if (apply_move(move))
+                nbdone++;
+        }
+        return nbdone;
+    }
+
+
+
+    bool apply_move(const string& move) {
+        if (move == "nni")
+            return apply_nni();
+        if (move == "spr")
+            return apply_spr();
+        if (move == "tbr")
+            return apply_tbr();
+        return false;
+    }
+
+
+
+    /**
+      Picks an internal edge (u, v), and swaps a random child of v with a random other child of u.
+      **/
+    bool apply_nni() {
+        for (int attempt = 0; attempt < MAX_ATTEMPTS; ++attempt) {
+            Node* v = get_random_node();
+            if (v->is_root() || v->is_leaf() || v->get_parent()->get_nb_children() < 2)
+                continue;
+
+            Node* u = v->get_parent();
+            Node* a = v->get_child(rng.next_int(v->get_nb_children()));
+            Node* b = u->get_child(rng.next_int(u->get_nb_children()));
+            if (b == v)
+                continue;
+
+            v->remove_child(a);
+            u->remove_child(b);
+            v->add_subtree(b);
+            u->add_subtree(a);
+            return true;
+        }
+        return false;
+    }
+
+
+
+    /**
+      Prunes a random subtree and regrafts it on a random edge outside of it.
+      **/
+    bool apply_spr() {
+        for (int attempt = 0; attempt < MAX_ATTEMPTS; ++attempt) {
+            Node* s = get_random_node();
+            Node* t = get_random_node();
+            if (!is_valid_spr(s, t))
+                continue;
+
+            double length = s->branch_length;
+            prune(s);
+            regraft(s, t, length);
+            return true;
+        }
+        return false;
+    }
+
+
+
+    /**
+      Like SPR, but the pruned subtree is first rerooted on a random edge of its own, found by
+      get_random_reroot_node.  Falls back to an SPR move if the pruned subtree has less than 3 leaves, since it
+      then has no other rooting.
+      **/
+    bool apply_tbr() {
+        for (int attempt = 0; attempt < MAX_ATTEMPTS; ++attempt) {
+            Node* s = get_random_node();
+            Node* t = get_random_node();
+            if (!is_valid_spr(s, t))
+                continue;
+
+            double length = s->branch_length;
+            Node* r = get_random_reroot_node(s);
+
+            prune(s);
+
+            Node* sub = s;
+            if (r) {
+                //reroot the pruned subtree on the middle of the edge above r, then suppress its old root s if it
+                //is left with one child
+                Node* x = TreeUtil::subdivide_parent_edge(r);
+                x->branch_length = r->branch_length / 2.0;
+                r->branch_length -= x->branch_length;
+                add_node(x);
+
+                TreeUtil::reroot_on_node(x);
+                if (s->get_nb_children() == 1)
+                    suppress(s);
+                sub = x;
+            }
+
+            regraft(sub, t, length);
+            return true;
+        }
+        return false;
+    }
+
+
+
+private:
+    Node* get_random_node() {
+        return nodes[rng.next_int(nodes.size())];
+    }
+
+    void add_node(Node* v) {
+        index[v] = nodes.size();
+        nodes.push_back(v);
+    }
+
+    void remove_node(Node* v) {
+        size_t i = index[v];
+        nodes[i] = nodes.back();
+        index[nodes[i]] = i;
+        nodes.pop_back();
+        index.erase(v);
+    }
+
+
+
+    /**
+      Random node in the subtree of s, below s, on whose parent edge the subtree can be rerooted to give another
+      rooting: a walk down from s that stops at each node with probability 1 / (number of children + 1).  If s has
+      2 children, the edges above them make a single edge of the unrooted subtree, so the walk starts below one of
+      them.  Returns nullptr if there is no such node, that is if the subtree has less than 3 leaves.
+      O(path length).
+      **/
+    Node* get_random_reroot_node(Node* s) {
+        vector<Node*> starts;
+        for (int i = 0; i < s->get_nb_children(); ++i) {
+            Node* c = s->get_child(i);
+            if (s->get_nb_children() != 2) {
+                starts.push_back(c);
+                continue;
+            }
+            for (int j = 0; j < c->get_nb_children(); ++j)
+                starts.push_back(c->get_child(j));
+        }
+        if (starts.empty())
+            return nullptr;
+
+        Node* r = starts[rng.next_int(starts.size())];
+        while (!r->is_leaf()) {
+            int i = rng.next_int(r->get_nb_children() + 1);
+            if (i == r->get_nb_children())
+                break;
+            r = r->get_child(i);
+        }
+        return r;
+    }
+
+
+
+    /**
+      s can be pruned and regrafted above t, and this changes the tree: s is not the root, t is not the root,
+      not in the subtree of s, not the parent of s nor its only sibling (regrafting there gives the same tree).
+      If the parent of s is a binary root, the sibling of s gets contracted into the root, so it must be internal.
+      **/
+    bool is_valid_spr(Node* s, Node* t) {
+        if (s->is_root() || t->is_root())
+            return false;
+
+        Node* p = s->get_parent();
+        if (t == p)
+            return false;
+
+        if (p->get_nb_children() == 2) {
+            Node* sibling = s->get_sibling();
+            if (t == sibling)
+                return false;
+            if (p->is_root() && sibling->is_leaf())
+                return false;
+        }
+
+        return !t->has_ancestor(s);
+    }
+
+
+
+    /**
+      Detaches s from the tree, and suppresses its parent if it is left with one child.
+      **/
+    void prune(Node* s) {
+        Node* p = s->get_parent();
+        p->remove_child(s);
+
+        if (p->get_nb_children() != 1)
+            return;
+
+        if (!p->is_root()) {
+            suppress(p);
+        }
+        else {
+            //the root keeps its identity, so its only child is contracted into it instead
+            Node* c = p->get_child(0);
+            for (int i = 0; i < c->get_nb_children(); ++i)
+                p->add_subtree(c->get_child(i));
+            c->remove_all_children(false);
+            p->remove_child(c);
+            remove_node(c);
+            delete c;
+        }
+    }
+
+
+
+    /**
+      Removes v, which has exactly one child, and links its child to its parent (if any) with the merged length.
+      If v is a root, its child becomes a root.
+      **/
+    void suppress(Node* v) {
+        Node* c = v->get_child(0);
+        v->remove_child(c);
+        c->branch_length += v->branch_length;
+
+        Node* g = v->get_parent();
+        if (g) {
+            g->remove_child(v);
+            g->add_subtree(c);
+        }
+
+        remove_node(v);
+        delete v;
+    }
+
+
+
+    /**
+      Attaches the subtree sub in the middle of the edge above t, with the given branch length.
+      **/
+    void regraft(Node* sub, Node* t, double length) {
+        Node* w = TreeUtil::subdivide_parent_edge(t);
+        w->branch_length = t->branch_length / 2.0;
+        t->branch_length -= w->branch_length;
+        add_node(w);
+
+        w->add_subtree(sub);
+        sub->branch_length = length;
+    }
+};
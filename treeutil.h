@@ -1,134 +1,549 @@
-#pragma once
-
-#include "node.h"
-#include "util.h"
-
-class TreeUtil {
-public:
-
-    static void get_random_binary_tree_rec(Node* v, set<int>& indices) {
-
-        if (indices.size() == 1) {
-            v->label = (Util::ToString(*indices.begin()));
-            return;
-        }
-
-        set<int> left;
-        set<int> right;
-
-        bool done = false;
-
-        while (!done) {
-            for (auto it = indices.begin(); it != indices.end(); ++it) {
-                int x = rand() % 2;
-                if (x == 0)
-                    left.insert(*it);
-                else
-                    right.insert(*it);
-            }
-
-            //dumb way to ensure no empty child
-            if (left.empty() || right.empty()) {
-                left.clear();
-                right.clear();
-            }
-            else {
-                done = true;
-            }
-        }
-
-
-        Node* v1 = new Node();
-        get_random_binary_tree_rec(v1, left);
-        Node* v2 = new Node();
-        get_random_binary_tree_rec(v2, right);
-
-        v->add_subtree(v1);
-        v->add_subtree(v2);
-    }
-
-
-
-
-
-    static void get_random_binary_tree(Node* root, int nb_leaves) {
-        set<int> labels;
-        for (int i = 1; i <= nb_leaves; ++i)
-            labels.insert(i);
-
-        return get_random_binary_tree_rec(root, labels);
-    }
-
-
-
-    static void contract_parent_edge(Node* v) {
-        if (v->is_root())
-            return;
-
-        Node* p = v->get_parent();
-        p->remove_child(v);
-        for (int i = 0; i < v->get_nb_children(); ++i) {
-            p->add_subtree(v->get_child(i));
-        }
-        v->remove_all_children(false);
-        delete v;
-    }
-
-
-
-
-    static void randomize_branch_lengths(Node* v, double min, double max) {
-        if (!v->is_root()) {
-            double r = (double)rand() / RAND_MAX;
-            double b = min + r * (max - min);
-            v->branch_length = b;
-        }
-
-        for (int i = 0; i < v->get_nb_children(); ++i) {
-            randomize_branch_lengths(v->get_child(i), min, max);
-        }
-
-    }
-
-    /**
-    Creates a degree 2 node between v and its parent, and returns the new node.  If v is the root, does nothing and returns nullptr.
-    **/
-    static Node* subdivide_parent_edge(Node* v) {
-        if (v->is_root())
-            return nullptr;
-
-        Node* old_parent = v->get_parent();
-        v->get_parent()->remove_child(v);
-
-        Node* w = new Node();
-        w->add_subtree(v);
-        old_parent->add_subtree(w);
-
-        return w;
-    }
-
-
-
-
-    static void reroot_on_node(Node* v) {
-        vector<Node*> ancestors;
-
-        Node* cur = v;
-        while (cur) {
-            ancestors.push_back(cur);
-            cur = cur->get_parent();
-        }
-
-
-        for (int i = ancestors.size() - 1; i >= 1; --i){
-            Node* w = ancestors[i];
-
-            w->remove_child(ancestors[i - 1]);
-            ancestors[i - 1]->add_subtree(w);
-        }
-
-
-    }
-
-
+#pragma once
+
+#include <cmath>
+
+#include "node.h"
+#include "util.h"
+#include "rng.h"
+
+class TreeUtil {
+public:
+
+    static void get_random_binary_tree_rec(Node* v, set<int>& indices) {
+
+        if (indices.size() == 1) {
+            v->label = (Util::ToString(*indices.begin()));
+            return;
+        }
+
+        set<int> left;
+        set<int> right;
+
+        bool done = false;
+
+        while (!done) {
+            for (auto it = indices.begin(); it != indices.end(); ++it) {
+                int x = rand() % 2;
+                if (x == 0)
+                    left.insert(*it);
+                else
+                    right.insert(*it);
+            }
+
+            //dumb way to ensure no empty child
+            if (left.empty() || right.empty()) {
+                left.clear();
+                right.clear();
+            }
+            else {
+                done = true;
+            }
+        }
+
+
+        Node* v1 = new Node();
+        get_random_binary_tree_rec(v1, left);
+        Node* v2 = new Node();
+        get_random_binary_tree_rec(v2, right);
+
+        v->add_subtree(v1);
+        v->add_subtree(v2);
+    }
+
+
+
+
+
+    static void get_random_binary_tree(Node* root, int nb_leaves) {
+        set<int> labels;
+        for (int i = 1; i <= nb_leaves; ++i)
+            labels.insert(i);
+
+        return get_random_binary_tree_rec(root, labels);
+    }
+
+
+
+    /**
+      Creates under root the binary tree whose internal node i has children ch0[i] and ch1[i] (-1 for leaves),
+      starting from node rootidx.  Children are created in ch0, ch1 order.  Leaves get the labels of leaf_labels
+      in left-to-right order if it is non-empty, or leaf_labels_by_node[index] otherwise.  If heights is given,
+      the branch length of each node is the height of its parent minus its own.  Iterative, so deep trees such as
+      caterpillars are fine.
+      **/
+    static void build_binary_tree(Node* root, int rootidx, const vector<int>& ch0, const vector<int>& ch1,
+                                  const vector<int>& leaf_labels, const vector<int>& leaf_labels_by_node = vector<int>(),
+                                  const vector<double>& heights = vector<double>()) {
+        vector<pair<int, Node*>> stack;
+        stack.push_back(make_pair(rootidx, root));
+        size_t nextlabel = 0;
+
+        while (!stack.empty()) {
+            int i = stack.back().first;
+            Node* v = stack.back().second;
+            stack.pop_back();
+
+            if (ch0[i] == -1) {
+                if (!leaf_labels.empty())
+                    v->label = Util::ToString(leaf_labels[nextlabel++]);
+                else
+                    v->label = Util::ToString(leaf_labels_by_node[i]);
+            }
+            else {
+                Node* v0 = v->add_child();
+                Node* v1 = v->add_child();
+                if (!heights.empty()) {
+                    v0->branch_length = heights[i] - heights[ch0[i]];
+                    v1->branch_length = heights[i] - heights[ch1[i]];
+                }
+                stack.push_back(make_pair(ch1[i], v1));
+                stack.push_back(make_pair(ch0[i], v0));
+            }
+        }
+    }
+
+
+
+    /**
+      Returns 1..nb_leaves in random order.
+      **/
+    static vector<int> get_shuffled_labels(int nb_leaves, Rng& rng) {
+        vector<int> labels(nb_leaves);
+        for (int i = 0; i < nb_leaves; ++i)
+            labels[i] = i + 1;
+        for (int i = nb_leaves - 1; i > 0; --i)
+            swap(labels[i], labels[rng.next_int(i + 1)]);
+        return labels;
+    }
+
+
+
+    /**
+      Same distribution as get_random_binary_tree (each leaf goes left or right with probability 1/2, conditioned
+      on both sides being non-empty), but driven by rng, with in-place partitions of an index array instead of sets
+      and without recursion.  Expected O(n log n).
+      **/
+    static void get_random_binary_tree(Node* root, int nb_leaves, Rng& rng) {
+        vector<int> labels = get_shuffled_labels(nb_leaves, rng);
+
+        vector<pair<pair<int, int>, Node*>> stack;
+        stack.push_back(make_pair(make_pair(0, nb_leaves), root));
+        while (!stack.empty()) {
+            int lo = stack.back().first.first;
+            int hi = stack.back().first.second;
+            Node* v = stack.back().second;
+            stack.pop_back();
+
+            if (hi - lo == 1) {
+                v->label = Util::ToString(labels[lo]);
+                continue;
+            }
+
+            int mid = lo;
+            while (mid == lo || mid == hi) {
+                mid = lo;
+                for (int k = lo; k < hi; ++k) {
+                    if (rng.next() >> 63)
+                        swap(labels[k], labels[mid++]);
+                }
+            }
+
+            Node* v0 = v->add_child();
+            Node* v1 = v->add_child();
+            stack.push_back(make_pair(make_pair(mid, hi), v1));
+            stack.push_back(make_pair(make_pair(lo, mid), v0));
+        }
+    }
+
+
+
+    /**
+      Rémy's algorithm: uniform random binary tree among the ordered (plane) binary trees with nb_leaves leaves,
+      in O(n).  Each step picks a uniform node among the 2k - 1 existing ones, and grafts a new leaf on its
+      parent edge, on a random side.
+      If labels_by_insertion is false, leaves are labelled 1..n from left to right, so that only the shape is random.
+      If true, each leaf is labelled by its insertion rank, which gives a uniform leaf-labelled rooted binary tree,
+      i.e. the PDA model (see get_pda_tree).
+      **/
+    static void get_uniform_random_binary_tree(Node* root, int nb_leaves, Rng& rng, bool labels_by_insertion = false) {
+        int nbnodes = 2 * nb_leaves - 1;
+        vector<int> ch0(nbnodes, -1), ch1(nbnodes, -1), parent(nbnodes, -1), leaf_label(nbnodes, 0);
+        int rootidx = 0;
+        leaf_label[0] = 1;
+
+        for (int k = 1; k < nb_leaves; ++k) {
+            int x = rng.next_int(2 * k - 1);
+            int w = 2 * k - 1;
+            int leaf = 2 * k;
+            int p = parent[x];
+
+            if (p == -1)
+                rootidx = w;
+            else if (ch0[p] == x)
+                ch0[p] = w;
+            else
+                ch1[p] = w;
+            parent[w] = p;
+
+            if (rng.next() >> 63) {
+                ch0[w] = x;
+                ch1[w] = leaf;
+            }
+            else {
+                ch0[w] = leaf;
+                ch1[w] = x;
+            }
+            parent[x] = parent[leaf] = w;
+            leaf_label[leaf] = k + 1;
+        }
+
+        if (labels_by_insertion) {
+            build_binary_tree(root, rootidx, ch0, ch1, vector<int>(), leaf_label);
+        }
+        else {
+            vector<int> in_order(nb_leaves);
+            for (int i = 0; i < nb_leaves; ++i)
+                in_order[i] = i + 1;
+            build_binary_tree(root, rootidx, ch0, ch1, in_order);
+        }
+    }
+
+
+
+    /**
+      Proportional to distinguishable arrangements: uniform among the (2n - 3)!! rooted binary trees on leaves 1..n.  O(n).
+      **/
+    static void get_pda_tree(Node* root, int nb_leaves, Rng& rng) {
+        get_uniform_random_binary_tree(root, nb_leaves, rng, true);
+    }
+
+
+
+    /**
+      Yule (pure birth) model: starting from a single leaf, a uniformly chosen leaf splits until there are nb_leaves.
+      Leaves are then labelled by a random permutation of 1..n.  O(n).
+      **/
+    static void get_yule_tree(Node* root, int nb_leaves, Rng& rng) {
+        int nbnodes = 2 * nb_leaves - 1;
+        vector<int> ch0(nbnodes, -1), ch1(nbnodes, -1);
+        vector<int> leaves;
+        leaves.reserve(nb_leaves);
+        leaves.push_back(0);
+        int nextnode = 1;
+
+        while ((int)leaves.size() < nb_leaves) {
+            int r = rng.next_int(leaves.size());
+            int x = leaves[r];
+            ch0[x] = nextnode;
+            ch1[x] = nextnode + 1;
+            leaves[r] = nextnode;
+            leaves.push_back(nextnode + 1);
+            nextnode += 2;
+        }
+
+        build_binary_tree(root, 0, ch0, ch1, get_shuffled_labels(nb_leaves, rng));
+    }
+
+
+
+    /**
+      Caterpillar (ladder) on nb_leaves leaves, with randomly permuted labels.
+      **/
+    static void get_caterpillar_tree(Node* root, int nb_leaves, Rng& rng) {
+        vector<int> labels = get_shuffled_labels(nb_leaves, rng);
+
+        Node* v = root;
+        for (int i = 0; i < nb_leaves - 1; ++i) {
+            Node* leaf = v->add_child();
+            leaf->label = Util::ToString(labels[i]);
+            if (i < nb_leaves - 2)
+                v = v->add_child();
+        }
+        if (nb_leaves == 1)
+            v->label = Util::ToString(labels[0]);
+        else
+            v->add_child()->label = Util::ToString(labels[nb_leaves - 1]);
+    }
+
+
+
+    /**
+      Balanced binary tree: every internal node splits its leaves in floor(k / 2) and ceil(k / 2).
+      Labels are randomly permuted.
+      **/
+    static void get_balanced_tree(Node* root, int nb_leaves, Rng& rng) {
+        vector<int> labels = get_shuffled_labels(nb_leaves, rng);
+
+        vector<pair<pair<int, int>, Node*>> stack;
+        stack.push_back(make_pair(make_pair(0, nb_leaves), root));
+        while (!stack.empty()) {
+            int lo = stack.back().first.first;
+            int hi = stack.back().first.second;
+            Node* v = stack.back().second;
+            stack.pop_back();
+
+            if (hi - lo == 1) {
+                v->label = Util::ToString(labels[lo]);
+                continue;
+            }
+            int mid = lo + (hi - lo) / 2;
+            Node* v0 = v->add_child();
+            Node* v1 = v->add_child();
+            stack.push_back(make_pair(make_pair(mid, hi), v1));
+            stack.push_back(make_pair(make_pair(lo, mid), v0));
+        }
+    }
+
+
+
+    /**
+      Kingman coalescent on nb_leaves leaves, with branch lengths.  While k lineages remain, a uniformly chosen pair
+      merges after an Exp(k(k - 1) / 2) waiting time, multiplied by scale (e.g. 2N for N diploid individuals, if
+      lengths should be in generations).  Leaves are at height 0.  O(n).
+      **/
+    static void get_coalescent_tree(Node* root, int nb_leaves, Rng& rng, double scale = 1.0) {
+        int nbnodes = 2 * nb_leaves - 1;
+        vector<int> ch0(nbnodes, -1), ch1(nbnodes, -1);
+        vector<double> heights(nbnodes, 0.0);
+        vector<int> lineages(nb_leaves);
+        for (int i = 0; i < nb_leaves; ++i)
+            lineages[i] = i;
+
+        double t = 0.0;
+        int nextnode = nb_leaves;
+        for (long long k = nb_leaves; k > 1; --k) {
+            t += -log(1.0 - rng.next_double()) / (k * (k - 1) / 2) * scale;
+
+            int a = rng.next_int(k);
+            swap(lineages[a], lineages[k - 1]);
+            int b = rng.next_int(k - 1);
+            swap(lineages[b], lineages[k - 2]);
+
+            ch0[nextnode] = lineages[k - 1];
+            ch1[nextnode] = lineages[k - 2];
+            heights[nextnode] = t;
+            lineages[k - 2] = nextnode;
+            nextnode++;
+        }
+
+        vector<int> labels_by_node(nb_leaves);
+        for (int i = 0; i < nb_leaves; ++i)
+            labels_by_node[i] = i + 1;
+        build_binary_tree(root, nbnodes - 1, ch0, ch1, vector<int>(), labels_by_node, heights);
+    }
+
+
+
+    /**
+      Reconstructed tree of a constant rate birth-death process (speciation rate birth, extinction rate death < birth),
+      conditioned on nb_leaves extant species, with a uniform prior on the time of origin (Gernhard 2008).
+      Uses the coalescent point process representation: the n - 1 node depths between consecutive extant leaves are
+      i.i.d. with P(H > t) = 1 / F(t), F(t) = 1 + (birth / r)(e^{rt} - 1), r = birth - death, conditioned on being
+      below the time of origin.  The origin is drawn through u = 1 - 1 / F(origin), whose density is proportional to
+      u^{n - 1} / (birth - death * u), by rejection from u = V^{1/n}.  The tree is then the Cartesian tree of the
+      depths, built with a stack.  Leaves are at height 0 and get random labels.  O(n).
+      Returns false if death >= birth (the process is not supercritical and the conditioning is improper).
+      **/
+    static bool get_birth_death_tree(Node* root, int nb_leaves, double birth, double death, Rng& rng) {
+        if (death >= birth || birth <= 0.0 || death < 0.0)
+            return false;
+
+        double r = birth - death;
+        double u;
+        do {
+            u = pow(rng.next_double(), 1.0 / nb_leaves);
+        } while (rng.next_double() * (birth - death * u) >= r);
+
+        int nbnodes = 2 * nb_leaves - 1;
+        vector<int> ch0(nbnodes, -1), ch1(nbnodes, -1);
+        vector<double> heights(nbnodes, 0.0);
+
+        //leaves are nodes 0..n-1, node n + i lies between leaves i and i + 1.  stack holds the right spine.
+        vector<int> stack;
+        stack.push_back(0);
+        for (int i = 0; i < nb_leaves - 1; ++i) {
+            double v = rng.next_double() * u;
+            double f = 1.0 / (1.0 - v);
+            double h = log1p((f - 1.0) * r / birth) / r;
+
+            int w = nb_leaves + i;
+            heights[w] = h;
+
+            int last = -1;
+            while (!stack.empty() && heights[stack.back()] < h) {
+                last = stack.back();
+                stack.pop_back();
+            }
+            ch0[w] = last;
+            ch1[w] = i + 1;
+            if (!stack.empty())
+                ch1[stack.back()] = w;
+            stack.push_back(w);
+            stack.push_back(i + 1);
+        }
+
+        build_binary_tree(root, stack[0], ch0, ch1, get_shuffled_labels(nb_leaves, rng), vector<int>(), heights);
+        return true;
+    }
+
+
+
+    /**
+      Dispatches to the generators above by model name: split, uniform, pda, yule, caterpillar, balanced,
+      coalescent or birthdeath (with rates birth and death).  Returns false if the model is unknown or its
+      parameters are invalid, including nb_leaves < 1.
+      **/
+    static bool get_random_tree(Node* root, int nb_leaves, const string& model, Rng& rng, double birth = 1.0, double death = 0.0) {
+        if (nb_leaves < 1)
+            return false;
+
+        if (model == "split")
+            get_random_binary_tree(root, nb_leaves, rng);
+        else if (model == "uniform")
+            get_uniform_random_binary_tree(root, nb_leaves, rng);
+        else if (model == "pda")
+            get_pda_tree(root, nb_leaves, rng);
+        else if (model == "yule")
+            get_yule_tree(root, nb_leaves, rng);
+        else if (model == "caterpillar")
+            get_caterpillar_tree(root, nb_leaves, rng);
+        else if (model == "balanced")
+            get_balanced_tree(root, nb_leaves, rng);
+        else if (model == "coalescent")
+            get_coalescent_tree(root, nb_leaves, rng);
+        else if (model == "birthdeath")
+            return get_birth_death_tree(root, nb_leaves, birth, death, rng);
+        else
+            return false;
+        return true;
+    }
+
+
+
+    /**
+      True if the model of get_random_tree gives meaningful branch lengths.
+      **/
+    static bool has_branch_lengths(const string& model) {
+        return model == "coalescent" || model == "birthdeath";
+    }
+
+
+
+    static void contract_parent_edge(Node* v) {
+        if (v->is_root())
+            return;
+
+        Node* p = v->get_parent();
+        p->remove_child(v);
+        for (int i = 0; i < v->get_nb_children(); ++i) {
+            p->add_subtree(v->get_child(i));
+        }
+        v->remove_all_children(false);
+        delete v;
+    }
+
+
+
+
+    static void randomize_branch_lengths(Node* v, double min, double max) {
+        if (!v->is_root()) {
+            double r = (double)rand() / RAND_MAX;
+            double b = min + r * (max - min);
+            v->branch_length = b;
+        }
+
+        for (int i = 0; i < v->get_nb_children(); ++i) {
+            randomize_branch_lengths(v->get_child(i), min, max);
+        }
+
+    }
+
+
+
+    /**
+      Same as above, driven by rng and without recursion.
+      **/
+    static void randomize_branch_lengths(Node* root, double min, double max, Rng& rng) {
+        for (Node* v : *root) {
+            if (!v->is_root())
+                v->branch_length = min + rng.next_double() * (max - min);
+        }
+    }
+
+
+
+    /**
+    Creates a degree 2 node between v and its parent, and returns the new node.  If v is the root, does nothing and returns nullptr.
+    **/
+    static Node* subdivide_parent_edge(Node* v) {
+        if (v->is_root())
+            return nullptr;
+
+        Node* old_parent = v->get_parent();
+        v->get_parent()->remove_child(v);
+
+        Node* w = new Node();
+        w->add_subtree(v);
+        old_parent->add_subtree(w);
+
+        return w;
+    }
+
+
+
+
+    /**
+      Roots the tree on the edge above v, at distance ratio x (length of the edge) from v, and suppresses the old
+      root if it is left with a single child (merging its two edges).  Returns the new root, or v if it is the root.
+      **/
+    static Node* reroot_on_edge(Node* v, double ratio = 0.5) {
+        if (v->is_root())
+            return v;
+
+        Node* old_root = v;
+        while (old_root->get_parent())
+            old_root = old_root->get_parent();
+
+        double length = v->branch_length;
+        Node* w = subdivide_parent_edge(v);
+        w->branch_length = length * (1.0 - ratio);
+        v->branch_length = length * ratio;
+        reroot_on_node(w);
+
+        if (old_root != w && old_root->get_nb_children() == 1) {
+            Node* c = old_root->get_child(0);
+            c->branch_length += old_root->branch_length;
+            contract_parent_edge(old_root);
+        }
+
+        return w;
+    }
+
+
+
+
+    static void reroot_on_node(Node* v) {
+        vector<Node*> ancestors;
+
+        Node* cur = v;
+        while (cur) {
+            ancestors.push_back(cur);
+            cur = cur->get_parent();
+        }
+
+
+        //each flipped edge keeps its length, which moves from the old child to the old parent
+        for (int i = ancestors.size() - 1; i >= 1; --i){
+            Node* w = ancestors[i];
+
+            w->remove_child(ancestors[i - 1]);
+            ancestors[i - 1]->add_subtree(w);
+            w->branch_length = ancestors[i - 1]->branch_length;
+        }
+        v->branch_length = 0.0;
+
+
+    }
+
+
 };
\ No newline at end of file